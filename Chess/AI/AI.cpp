@@ -51,21 +51,14 @@ namespace Chess
 		timeLeft = newTimeLeft;
 	}
 
-	std::chrono::milliseconds calculateMaxSearchTime(std::chrono::milliseconds timeLeft)
+	void AI::setIncrement(std::chrono::milliseconds newIncrement)
 	{
-		return timeLeft / 300;
-		//return std::chrono::milliseconds(10000000);
+		increment = newIncrement;
 	}
 
-	void AI::updateTime(std::chrono::milliseconds timeSinceLastUpdate)
+	void AI::setMovesToGo(int newMovesToGo)
 	{
-		timeLeft -= timeSinceLastUpdate;
-		searchTime -= timeSinceLastUpdate;
-
-		if (isSearching && (searchTime < std::chrono::milliseconds(0)))
-		{
-			search.stopSearch();
-		}
+		movesToGo = newMovesToGo;
 	}
 
 	void AI::forceStopSearch()
@@ -73,9 +66,12 @@ namespace Chess
 		search.stopSearch();
 	}
 
-	Move AI::getBestMove(ChessBoard board)
+	Move AI::getBestMove(ChessBoard board, std::stop_token stopToken)
 	{
-		if (isFollowingBook)
+		ponderMove = Move{ 0, 0 };
+
+		// a ponder search has to keep searching until the ponder hit, so the book is skipped
+		if (isFollowingBook && !search.isPondering())
 		{
 			Move bookMove = getBookMove(board.getZobristKey());
 
@@ -91,17 +87,40 @@ namespace Chess
 			}
 		}
 
-		searchTime = calculateMaxSearchTime(timeLeft);
-		isSearching = true;
+		search.setTimeLimits(timeLeft, increment, movesToGo);
 
-		Move bestMove = search.searchBestMove(board);
+		Move bestMove = search.searchBestMove(board, stopToken);
 		evaluation = search.getEvaluation();
 
-		isSearching = false;
+		// expected reply is the second move of the principal variation
+		SearchInfo info = search.getSearchInfo();
+
+		if (!info.lines.empty() && info.lines[0].moves.size() > 1 && info.lines[0].moves[0] == bestMove)
+		{
+			ponderMove = info.lines[0].moves[1];
+		}
 
 		return bestMove;
 	}
 
+	void AI::analyze(ChessBoard board, std::stop_token stopToken)
+	{
+		search.startPondering();
+		search.searchBestMove(board, stopToken);
+
+		evaluation = search.getEvaluation();
+	}
+
+	void AI::startPondering()
+	{
+		search.startPondering();
+	}
+
+	void AI::ponderHit()
+	{
+		search.ponderHit();
+	}
+
 	void AI::reset()
 	{
 		isFollowingBook = true;
@@ -9,13 +9,6 @@
 #include "Book.h"
 #include "Search.h"
 
-#if !defined(LICHESS_BOOK_PATH) || !defined(MASTER_BOOK_PATH)
-
-#define MASTER_BOOK_PATH "./Books/MasterBook.txt"
-#define LICHESS_BOOK_PATH "./Books/LichessBook.txt"
-
-#endif
-
 namespace Chess
 {
 	class AI
@@ -31,27 +24,43 @@ namespace Chess
 
 		static constexpr std::chrono::milliseconds delayBookMillis = std::chrono::milliseconds(250);
 
+		// clock of the side the AI plays, movesToGo = 0 means sudden death
 		std::chrono::milliseconds timeLeft = std::chrono::milliseconds(0);
-		std::chrono::milliseconds searchTime = std::chrono::milliseconds(0);
+		std::chrono::milliseconds increment = std::chrono::milliseconds(0);
+		int movesToGo = 0;
 
 		bool isFollowingBook = true;
-		bool isSearching = false;
 		int evaluation = 0;
 
+		// opponent's reply expected after the last best move, null if unknown
+		Move ponderMove = Move{ 0, 0 };
+
 	public:
 		bool white = false;
 
 		// Move generation
 		Move getRandomMove(ChessBoard chessBoard);
-		Move getBestMove(ChessBoard board);
+		Move getBestMove(ChessBoard board, std::stop_token stopToken = {});
 		Move getBookMove(uint64_t zobristKey) const;
 
+		// Pondering, the next getBestMove (given the position after the ponder move) runs until ponderHit or stop
+		void startPondering();
+		void ponderHit();
+		Move getPonderMove() const { return ponderMove; };
+
+		// Searches without limits until stopToken is requested or forceStopSearch is called
+		void analyze(ChessBoard board, std::stop_token stopToken = {});
+		void setInfoCallback(SearchInfoCallback callback) { search.setInfoCallback(std::move(callback)); };
+
 		void forceStopSearch();
-		void updateTime(std::chrono::milliseconds timeSinceLastUpdate);
 		void setTimeLeft(std::chrono::milliseconds timeLeft);
+		void setIncrement(std::chrono::milliseconds increment);
+		void setMovesToGo(int movesToGo);
+		void setMultiPV(int lines) { search.setMultiPV(lines); };
 
 		std::unordered_map<Move, int> getAllBookMoves(const ChessBoard& board) const;
 		SearchStats getSearchStats() const { return search.getSearchStats(); };
+		SearchInfo getSearchInfo() const { return search.getSearchInfo(); };
 		int getEvaluation() const { return evaluation; };
 
 		void reset();
@@ -4,6 +4,13 @@
 
 #include "Move.h"
 
+#if !defined(LICHESS_BOOK_PATH) || !defined(MASTER_BOOK_PATH)
+
+#define MASTER_BOOK_PATH "./Books/MasterBook.txt"
+#define LICHESS_BOOK_PATH "./Books/LichessBook.txt"
+
+#endif
+
 namespace Chess
 {
 	class Book
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <cassert>
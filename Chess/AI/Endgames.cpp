@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include "Endgames.h"
+#include "Evaluation.h"
+#include "PawnHash.h"
+
+namespace Chess::Endgames
+{
+	namespace
+	{
+		// a8 (square 0) is a light square
+		constexpr uint64_t lightSquares = 0xaa55aa55'aa55aa55ULL;
+
+		int rowOf(int square)
+		{
+			return square / 8;
+		}
+
+		int colOf(int square)
+		{
+			return square % 8;
+		}
+
+		// king moves between the squares
+		int distance(int from, int to)
+		{
+			return std::max(std::abs(rowOf(from) - rowOf(to)), std::abs(colOf(from) - colOf(to)));
+		}
+
+		int manhattanDistance(int from, int to)
+		{
+			return std::abs(rowOf(from) - rowOf(to)) + std::abs(colOf(from) - colOf(to));
+		}
+
+		// square seen from the strong side, which moves its pawns towards row 0 like white
+		int relativeSquare(int square, bool strongWhite)
+		{
+			return strongWhite ? square : square ^ 56;
+		}
+
+		int colorOf(bool white)
+		{
+			return white ? Piece::White : Piece::Black;
+		}
+
+		int nonPawnMaterial(uint64_t materialKey, bool white)
+		{
+			int color = colorOf(white);
+			int material = 0;
+
+			for (int type : { Piece::Rook, Piece::Knight, Piece::Bishop, Piece::Queen })
+			{
+				material += MaterialKey::count(materialKey, type | color) * Evaluation::pieceValues[type];
+			}
+
+			return material;
+		}
+
+		// drives the opponent king to the edge and the own king towards it
+		int forceKingToCorner(uint64_t king, uint64_t opponentKing)
+		{
+			int evaluation = 0;
+
+			int friendlyIndex = std::countr_zero(king);
+			int opponentIndex = std::countr_zero(opponentKing);
+
+			int opponentRank = opponentIndex / 8;
+			int opponentFile = opponentIndex % 8;
+
+			// force opponent king to the corner
+			int opponentDistanceCenterFile = std::max(3 - opponentFile, opponentFile - 4);
+			int opponentDistanceCenterRank = std::max(3 - opponentRank, opponentRank - 4);
+			int opponentDistanceFromCenter = opponentDistanceCenterFile + opponentDistanceCenterRank;
+			evaluation += opponentDistanceFromCenter;
+
+			// distance between kings
+			evaluation += 15 - manhattanDistance(friendlyIndex, opponentIndex);
+
+			return evaluation;
+		}
+
+		// Lone king against at least a rook's worth of pieces, won with mating material
+		int evaluateKXK(const ChessBoard& chessBoard, bool strongWhite)
+		{
+			std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+			uint64_t materialKey = chessBoard.getAccumulator().materialKey;
+			int strong = colorOf(strongWhite);
+			int weak = colorOf(!strongWhite);
+
+			int result = nonPawnMaterial(materialKey, strongWhite) + MaterialKey::count(materialKey, Piece::Pawn | strong) * Evaluation::pieceValues[Piece::Pawn];
+			result += 10 * forceKingToCorner(bitboards[Piece::King | strong], bitboards[Piece::King | weak]);
+
+			uint64_t bishops = bitboards[Piece::Bishop | strong];
+			bool bishopsOnBothColors = (bishops & lightSquares) && (bishops & ~lightSquares);
+
+			if (bitboards[Piece::Queen | strong] || bitboards[Piece::Rook | strong] || (bishops && bitboards[Piece::Knight | strong]) || bishopsOnBothColors)
+			{
+				result += knownWin;
+			}
+
+			return strongWhite ? result : -result;
+		}
+
+		// Mate is only possible in a corner of the bishop's color
+		int evaluateKBNK(const ChessBoard& chessBoard, bool strongWhite)
+		{
+			std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+			int strong = colorOf(strongWhite);
+			int weak = colorOf(!strongWhite);
+
+			int strongKing = std::countr_zero(bitboards[Piece::King | strong]);
+			int weakKing = std::countr_zero(bitboards[Piece::King | weak]);
+			bool lightBishop = bitboards[Piece::Bishop | strong] & lightSquares;
+
+			// a8 and h1 are light, h8 and a1 dark
+			int cornerDistance = lightBishop ?
+				std::min(manhattanDistance(weakKing, 0), manhattanDistance(weakKing, 63)) :
+				std::min(manhattanDistance(weakKing, 7), manhattanDistance(weakKing, 56));
+
+			int result = knownWin + Evaluation::pieceValues[Piece::Knight] + Evaluation::pieceValues[Piece::Bishop];
+			result += 20 * (14 - cornerDistance) + 10 * (7 - distance(strongKing, weakKing));
+
+			return strongWhite ? result : -result;
+		}
+
+		int evaluateKPK(const ChessBoard& chessBoard, bool strongWhite)
+		{
+			std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+			int strong = colorOf(strongWhite);
+			int weak = colorOf(!strongWhite);
+
+			int strongKing = relativeSquare(std::countr_zero(bitboards[Piece::King | strong]), strongWhite);
+			int weakKing = relativeSquare(std::countr_zero(bitboards[Piece::King | weak]), strongWhite);
+			int pawn = relativeSquare(std::countr_zero(bitboards[Piece::Pawn | strong]), strongWhite);
+
+			// the bitbase only has pawns on the a-d files
+			if (colOf(pawn) >= 4)
+			{
+				strongKing ^= 7;
+				weakKing ^= 7;
+				pawn ^= 7;
+			}
+
+			bool strongToMove = chessBoard.isWhiteToMove() == strongWhite;
+
+			// further advanced pawns first, so the search makes progress
+			int result = isKPKWin(strongKing, pawn, weakKing, strongToMove) ?
+				knownWin + Evaluation::pieceValues[Piece::Pawn] + (7 - rowOf(pawn)) : 0;
+
+			return strongWhite ? result : -result;
+		}
+
+		// Rook against pawn, won unless the pawn is far advanced and supported by its king
+		int evaluateKRKP(const ChessBoard& chessBoard, bool strongWhite)
+		{
+			std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+			int strong = colorOf(strongWhite);
+			int weak = colorOf(!strongWhite);
+
+			int strongKing = relativeSquare(std::countr_zero(bitboards[Piece::King | strong]), strongWhite);
+			int weakKing = relativeSquare(std::countr_zero(bitboards[Piece::King | weak]), strongWhite);
+			int rook = relativeSquare(std::countr_zero(bitboards[Piece::Rook | strong]), strongWhite);
+			int pawn = relativeSquare(std::countr_zero(bitboards[Piece::Pawn | weak]), strongWhite);
+
+			// the pawn runs towards row 7 here
+			int queeningSquare = 56 + colOf(pawn);
+			int pushSquare = pawn + 8;
+			bool strongToMove = chessBoard.isWhiteToMove() == strongWhite;
+			int rookValue = Evaluation::pieceValues[Piece::Rook];
+			int result;
+
+			// the strong king stands in front of the pawn
+			if (colOf(strongKing) == colOf(pawn) && rowOf(strongKing) > rowOf(pawn))
+			{
+				result = rookValue - distance(strongKing, pawn);
+			}
+			// the weak king is too far from the pawn and the rook
+			else if (distance(weakKing, pawn) >= 3 + !strongToMove && distance(weakKing, rook) >= 3)
+			{
+				result = rookValue - distance(strongKing, pawn);
+			}
+			// far advanced pawn supported by its king while the strong king is far away
+			else if (rowOf(weakKing) >= 5 && distance(weakKing, pawn) == 1 && rowOf(strongKing) <= 4 && distance(strongKing, pawn) > 2 + strongToMove)
+			{
+				result = 80 - 8 * distance(strongKing, pawn);
+			}
+			else
+			{
+				result = 200 - 8 * (distance(strongKing, pushSquare) - distance(weakKing, pushSquare) - distance(pawn, queeningSquare));
+			}
+
+			return strongWhite ? result : -result;
+		}
+
+		// Two knights cannot force mate
+		int evaluateKNNK(const ChessBoard&, bool)
+		{
+			return 0;
+		}
+
+		// Opposite-colored bishops are drawish, the more so without other pieces
+		int scaleOppositeBishops(const ChessBoard& chessBoard, const PawnEntry& pawns, bool strongWhite)
+		{
+			std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+			uint64_t bishops = bitboards[Piece::WhiteBishop] | bitboards[Piece::BlackBishop];
+
+			// one bishop each, so opposite colors leave exactly one on a light square
+			if (std::popcount(bishops & lightSquares) != 1)
+			{
+				return normalScale;
+			}
+
+			uint64_t materialKey = chessBoard.getAccumulator().materialKey;
+			int bishopValue = Evaluation::pieceValues[Piece::Bishop];
+
+			if (nonPawnMaterial(materialKey, true) == bishopValue && nonPawnMaterial(materialKey, false) == bishopValue)
+			{
+				return std::min(normalScale, 16 + 4 * std::popcount(pawns.passedPawns[strongWhite]));
+			}
+
+			return std::min(normalScale, 22 + 3 * std::popcount(chessBoard.getOccupiedSquares(strongWhite)));
+		}
+
+		// Without pawns the strong side needs more than a minor piece ahead to win
+		int scalePawnless(const ChessBoard& chessBoard, const PawnEntry&, bool strongWhite)
+		{
+			uint64_t materialKey = chessBoard.getAccumulator().materialKey;
+
+			if (nonPawnMaterial(materialKey, strongWhite) < Evaluation::pieceValues[Piece::Rook])
+			{
+				return 0;
+			}
+
+			return nonPawnMaterial(materialKey, !strongWhite) <= Evaluation::pieceValues[Piece::Bishop] ? 4 : 14;
+		}
+
+		// Registry of the endgames with an exact material, open addressing over a fixed table
+		struct Specialization
+		{
+			std::string_view code;
+			Evaluator evaluate;
+		};
+
+		constexpr std::array<Specialization, 4> specializations = { {
+			{ "KBNK", evaluateKBNK },
+			{ "KPK", evaluateKPK },
+			{ "KRKP", evaluateKRKP },
+			{ "KNNK", evaluateKNNK }
+		} };
+
+		struct RegistryEntry
+		{
+			uint64_t materialKey = 0ULL;
+			bool used = false;
+			Endgame endgame;
+		};
+
+		constexpr size_t registrySize = 64;	// power of 2, a few times the number of keys
+
+		constexpr size_t registryIndex(uint64_t materialKey)
+		{
+			return static_cast<size_t>((materialKey * 0x9e3779b9'7f4a7c15ULL) >> 58);
+		}
+
+		consteval std::array<RegistryEntry, registrySize> buildRegistry()
+		{
+			std::array<RegistryEntry, registrySize> registry{};
+
+			for (const Specialization& specialization : specializations)
+			{
+				for (bool strongWhite : { true, false })
+				{
+					uint64_t materialKey = MaterialKey::fromCode(specialization.code);
+					materialKey = strongWhite ? materialKey : MaterialKey::mirror(materialKey);
+
+					size_t index = registryIndex(materialKey);
+					while (registry[index].used)
+					{
+						index = (index + 1) & (registrySize - 1);
+					}
+
+					registry[index] = RegistryEntry{ materialKey, true, Endgame{ specialization.evaluate, strongWhite } };
+				}
+			}
+
+			return registry;
+		}
+
+		constexpr std::array<RegistryEntry, registrySize> registry = buildRegistry();
+
+		// KPK bitbase, every position of kings and a white pawn on the a-d files with either side to move
+		constexpr int kpkPawnSquares = 24;
+		constexpr size_t kpkSize = 2 * 64 * 64 * kpkPawnSquares;
+
+		// results are or-ed over the moves of a position
+		enum KPKResult : uint8_t
+		{
+			Invalid = 0,
+			Unknown = 1,
+			Draw = 2,
+			Win = 4
+		};
+
+		// pawns on rows 1 to 6 (ranks 7 to 2)
+		size_t kpkIndex(bool strongToMove, int strongKing, int weakKing, int pawn)
+		{
+			size_t pawnIndex = (rowOf(pawn) - 1) * 4 + colOf(pawn);
+			return ((pawnIndex * 64 + strongKing) * 64 + weakKing) * 2 + strongToMove;
+		}
+
+		uint64_t kingAttacks(int square)
+		{
+			return ChessBoard::getThreatMapforKing(1ULL << square);
+		}
+
+		KPKResult initialKPKResult(bool strongToMove, int strongKing, int weakKing, int pawn)
+		{
+			uint64_t pawnAttacks = ChessBoard::getThreatMapforPawn(1ULL << pawn, true);
+
+			if (distance(strongKing, weakKing) <= 1 || strongKing == pawn || weakKing == pawn ||
+				(strongToMove && (pawnAttacks & (1ULL << weakKing))))
+			{
+				return Invalid;
+			}
+
+			// the pawn promotes and the queen cannot be taken
+			if (strongToMove && rowOf(pawn) == 1 && strongKing != pawn - 8 &&
+				(distance(weakKing, pawn - 8) > 1 || distance(strongKing, pawn - 8) == 1))
+			{
+				return Win;
+			}
+
+			if (!strongToMove)
+			{
+				uint64_t weakMoves = kingAttacks(weakKing) & ~kingAttacks(strongKing);
+
+				// stalemate or the pawn is taken
+				if ((weakMoves & ~pawnAttacks) == 0 || (weakMoves & (1ULL << pawn)))
+				{
+					return Draw;
+				}
+			}
+
+			return Unknown;
+		}
+
+		// the strong side needs one winning move, the weak side one drawing move
+		KPKResult classifyKPK(const std::vector<uint8_t>& table, bool strongToMove, int strongKing, int weakKing, int pawn)
+		{
+			KPKResult good = strongToMove ? Win : Draw;
+			KPKResult bad = strongToMove ? Draw : Win;
+
+			int result = Invalid;
+			uint64_t moves = kingAttacks(strongToMove ? strongKing : weakKing);
+
+			while (moves)
+			{
+				int to = std::countr_zero(moves);
+
+				result |= strongToMove ?
+					table[kpkIndex(false, to, weakKing, pawn)] :
+					table[kpkIndex(true, strongKing, to, pawn)];
+
+				moves &= (moves - 1);
+			}
+
+			// promotions are already decided, pushes onto a king are invalid positions
+			if (strongToMove && rowOf(pawn) > 1)
+			{
+				result |= table[kpkIndex(false, strongKing, weakKing, pawn - 8)];
+
+				if (rowOf(pawn) == 6 && pawn - 8 != strongKing && pawn - 8 != weakKing)
+				{
+					result |= table[kpkIndex(false, strongKing, weakKing, pawn - 16)];
+				}
+			}
+
+			return (result & good) ? good : (result & Unknown) ? Unknown : bad;
+		}
+
+		template <typename Visit>
+		void forEachKPKPosition(const Visit& visit)
+		{
+			for (int pawnIndex = 0; pawnIndex < kpkPawnSquares; pawnIndex++)
+			{
+				int pawn = (pawnIndex / 4 + 1) * 8 + pawnIndex % 4;
+
+				for (int strongKing = 0; strongKing < 64; strongKing++)
+				{
+					for (int weakKing = 0; weakKing < 64; weakKing++)
+					{
+						visit(false, strongKing, weakKing, pawn);
+						visit(true, strongKing, weakKing, pawn);
+					}
+				}
+			}
+		}
+
+		// retrograde analysis, unknown positions are classified until nothing changes
+		std::vector<uint8_t> buildKPK()
+		{
+			std::vector<uint8_t> table(kpkSize);
+
+			forEachKPKPosition([&](bool strongToMove, int strongKing, int weakKing, int pawn)
+				{
+					table[kpkIndex(strongToMove, strongKing, weakKing, pawn)] = initialKPKResult(strongToMove, strongKing, weakKing, pawn);
+				});
+
+			bool changed = true;
+
+			while (changed)
+			{
+				changed = false;
+
+				forEachKPKPosition([&](bool strongToMove, int strongKing, int weakKing, int pawn)
+					{
+						uint8_t& result = table[kpkIndex(strongToMove, strongKing, weakKing, pawn)];
+
+						if (result == Unknown)
+						{
+							result = classifyKPK(table, strongToMove, strongKing, weakKing, pawn);
+							changed = changed || result != Unknown;
+						}
+					});
+			}
+
+			return table;
+		}
+	}
+
+	bool isKPKWin(int strongKing, int pawn, int weakKing, bool strongToMove)
+	{
+		// built on first use
+		static const std::vector<uint8_t> table = buildKPK();
+
+		return table[kpkIndex(strongToMove, strongKing, weakKing, pawn)] == Win;
+	}
+
+	Endgame probe(uint64_t materialKey)
+	{
+		for (size_t index = registryIndex(materialKey); registry[index].used; index = (index + 1) & (registrySize - 1))
+		{
+			if (registry[index].materialKey == materialKey)
+			{
+				return registry[index].endgame;
+			}
+		}
+
+		Endgame endgame;
+
+		for (bool strongWhite : { true, false })
+		{
+			uint64_t weakPieces = materialKey & (strongWhite ? MaterialKey::blackPieces : MaterialKey::whitePieces);
+			int strongMaterial = nonPawnMaterial(materialKey, strongWhite);
+
+			if (weakPieces == 0 && strongMaterial >= Evaluation::pieceValues[Piece::Rook])
+			{
+				return Endgame{ evaluateKXK, strongWhite };
+			}
+
+			if (MaterialKey::count(materialKey, Piece::Pawn | colorOf(strongWhite)) == 0 &&
+				strongMaterial - nonPawnMaterial(materialKey, !strongWhite) <= Evaluation::pieceValues[Piece::Bishop])
+			{
+				endgame.scale[strongWhite] = scalePawnless;
+			}
+		}
+
+		if (MaterialKey::count(materialKey, Piece::WhiteBishop) == 1 && MaterialKey::count(materialKey, Piece::BlackBishop) == 1)
+		{
+			for (Scaler& scale : endgame.scale)
+			{
+				scale = scale ? scale : scaleOppositeBishops;
+			}
+		}
+
+		return endgame;
+	}
+
+	int scaleFor(const Endgame& endgame, const ChessBoard& chessBoard, const PawnEntry& pawns, int evaluation)
+	{
+		bool whiteAhead = evaluation > 0;
+		Scaler scale = endgame.scale[whiteAhead];
+
+		return scale ? scale(chessBoard, pawns, whiteAhead) : normalScale;
+	}
+}
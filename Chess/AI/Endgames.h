@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "ChessBoard.h"
+
+namespace Chess
+{
+	struct PawnEntry;
+}
+
+namespace Chess::Endgames
+{
+	// Evaluations are multiplied by scale / normalScale
+	static constexpr int normalScale = 64;
+
+	// Positions a specialized evaluation knows to be won, below any mate score
+	static constexpr int knownWin = 10000;
+
+	// Evaluation of a specialized endgame from white's point of view, replaces the normal evaluation
+	using Evaluator = int(*)(const ChessBoard& chessBoard, bool strongWhite);
+
+	// Scale of the normal evaluation when it favors the strong side
+	using Scaler = int(*)(const ChessBoard& chessBoard, const PawnEntry& pawns, bool strongWhite);
+
+	struct Endgame
+	{
+		Evaluator evaluate = nullptr;
+		bool strongWhite = true;
+
+		// [0] when black is ahead, [1] when white is ahead
+		std::array<Scaler, 2> scale{};
+	};
+
+	// Specialized evaluation and scaling of the material, O(1). Exact material keys (KBNK, KPK, KRKP, KNNK)
+	// come from a fixed registry, a lone king against enough material (KXK), opposite-colored bishops and
+	// pawnless positions with a small advantage are recognized by the key itself
+	Endgame probe(uint64_t materialKey);
+
+	// Scale of the evaluation in the position, normalScale if nothing applies
+	int scaleFor(const Endgame& endgame, const ChessBoard& chessBoard, const PawnEntry& pawns, int evaluation);
+
+	// KPK bitbase, the strong side is white with its pawn on the a-d files (square 0 is a8)
+	bool isKPKWin(int strongKing, int pawn, int weakKing, bool strongToMove);
+}
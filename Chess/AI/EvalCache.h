@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Chess
+{
+	// Fixed size cache of static evaluations indexed by the zobrist key. Lockless, the key is stored
+	// xored with the data, so an entry torn by a concurrent write fails verification instead of
+	// returning the wrong score
+	class EvalCache
+	{
+		static constexpr size_t tableSize = 1 << 16;	// power of 2
+
+		struct Entry
+		{
+			std::atomic<uint64_t> keyXorData = 0;
+			std::atomic<uint64_t> data = 0;
+		};
+
+		std::unique_ptr<Entry[]> entries = std::make_unique<Entry[]>(tableSize);
+
+	public:
+		bool probe(uint64_t key, int& evaluation) const
+		{
+			const Entry& entry = entries[key & (tableSize - 1)];
+
+			uint64_t data = entry.data.load(std::memory_order_relaxed);
+			uint64_t keyXorData = entry.keyXorData.load(std::memory_order_relaxed);
+
+			// an empty entry only matches key 0, which the board never uses for a real position
+			if ((keyXorData ^ data) != key || key == 0)
+			{
+				return false;
+			}
+
+			evaluation = static_cast<int32_t>(static_cast<uint32_t>(data));
+			return true;
+		}
+
+		void store(uint64_t key, int evaluation)
+		{
+			Entry& entry = entries[key & (tableSize - 1)];
+			uint64_t data = static_cast<uint32_t>(evaluation);
+
+			entry.data.store(data, std::memory_order_relaxed);
+			entry.keyXorData.store(key ^ data, std::memory_order_relaxed);
+		}
+
+		void clear()
+		{
+			for (size_t i = 0; i < tableSize; i++)
+			{
+				entries[i].data.store(0, std::memory_order_relaxed);
+				entries[i].keyXorData.store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+}
@@ -2,18 +2,13 @@
 #include <bit>
 
 #include "Evaluation.h"
-#include "PieceSquareTables.h"
+#include "EvaluationKernels.h"
+#include "PawnHash.h"
 
 namespace Chess::Evaluation
 {
-	int flipFull(int sq)
-	{
-		assert(sq >= 0 && sq < 64);
-		return (sq ^ 56);
-	}
-
 	// Add points for each piece, prioritize queens and rooks
-	float calculateGamePhase(const ChessBoard& chessBoard)
+	int calculateGamePhase(const ChessBoard& chessBoard)
 	{
 		// 0 to 100 here
 		int gamePhase = 0;
@@ -21,11 +16,8 @@ namespace Chess::Evaluation
 		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
 		GameState gameState = chessBoard.getGameState();
 
-		// add up all pieces
-		gamePhase += std::popcount(bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen]) * 10;
-		gamePhase += std::popcount(bitboards[Piece::WhiteRook] | bitboards[Piece::BlackRook]) * 5;
-		gamePhase += std::popcount(bitboards[Piece::WhiteKnight] | bitboards[Piece::BlackKnight]) * 3;
-		gamePhase += std::popcount(bitboards[Piece::WhiteBishop] | bitboards[Piece::BlackBishop]) * 4;
+		// add up all pieces, kept by the board (queen 10, rook 5, bishop 4, knight 3)
+		gamePhase += chessBoard.getAccumulator().gamePhase;
 		gamePhase += std::popcount(bitboards[Piece::WhitePawn] | bitboards[Piece::BlackPawn]) / 2;
 
 		gamePhase += 5 * (int)gameState.getKingsideCastlingRights(true);
@@ -35,335 +27,545 @@ namespace Chess::Evaluation
 
 		assert(gamePhase <= 105);
 
-		return (float)gamePhase / 100.0f;
+		// extra queens from promotions do not make the position more of an opening
+		return std::min(gamePhase, maxGamePhase);
 	}
 
-	int applyPSTWhite(uint64_t pieces, const int* PST)
+	// the file mask constants are named after the columns, COL1 is the a-file
+	uint64_t spreadToAdjacentFiles(uint64_t squares)
 	{
-		int evaluation = 0;
+		return squares | ((squares << 1) & ~Consts::COL1) | ((squares >> 1) & ~Consts::COL8);
+	}
 
-		while (pieces)
-		{
-			evaluation += PST[std::countr_zero(pieces)];
-			pieces &= (pieces - 1);
-		}
+	// every square on a file with at least one of the squares
+	uint64_t fillFiles(uint64_t squares)
+	{
+		squares |= squares >> 32;
+		squares |= squares >> 16;
+		squares |= squares >> 8;
 
-		return evaluation;
+		return (squares & Consts::ROW1) * Consts::COL1;
 	}
 
-
-	int applyPSTBlack(uint64_t pieces, const int* PST)
+	// squares without enemy pawns ahead on the same or an adjacent file, the bitboard version of
+	// the passed pawn tables (squares outside of the tables are never blocked)
+	uint64_t findOutposts(uint64_t enemyPawns, bool white)
 	{
-		int evaluation = 0;
+		uint64_t blocked = spreadToAdjacentFiles(enemyPawns);
 
-		while (pieces)
+		// white pawns move towards a8 (square 0), so they are blocked by pawns on lower squares
+		if (white)
+		{
+			blocked |= blocked << 8;
+			blocked |= blocked << 16;
+			blocked |= blocked << 32;
+			blocked = (blocked << 8) & ~(Consts::ROW1 | Consts::ROW2 | Consts::ROW8);
+		}
+		else
 		{
-			evaluation += PST[flipFull(std::countr_zero(pieces))];
-			pieces &= (pieces - 1);
+			blocked |= blocked >> 8;
+			blocked |= blocked >> 16;
+			blocked |= blocked >> 32;
+			blocked = (blocked >> 8) & ~(Consts::ROW1 | Consts::ROW7 | Consts::ROW8);
 		}
 
-		return evaluation;
+		return ~blocked;
 	}
 
-	int applyPassedPawns(uint64_t pawns, uint64_t enemyPawns, bool white)
+	uint64_t findIsolatedPawns(uint64_t pawns)
 	{
-		int colorIndex = int(white);
-		int bonus = 0;
+		uint64_t files = fillFiles(pawns);
+		uint64_t neighborFiles = ((files << 1) & ~Consts::COL1) | ((files >> 1) & ~Consts::COL8);
 
-		uint64_t promotionRow = white ? Consts::ROW2 : Consts::ROW7;
+		return pawns & ~neighborFiles;
+	}
+
+	// pawns with another pawn on the right, so 2 connected pawns count once, 3 twice...
+	uint64_t findConnectedPawns(uint64_t pawns)
+	{
+		return ((pawns & ~Consts::COL8) << 1) & pawns;
+	}
+
+	// Bitboards counted by the kernel and their parameters, white's bitboard of a parameter comes first and
+	// black's second, so every weight is followed by its negation
+	namespace
+	{
+		constexpr int pawnTerms = 8;
+		constexpr std::array<Parameter, pawnTerms / 2> pawnParameters = {
+			DoubledPawn, PassedPawn, IsolatedPawn, ConnectedPawn
+		};
+
+		constexpr int pieceTerms = 16;
+		constexpr std::array<Parameter, pieceTerms / 2> pieceParameters = {
+			PawnDefender, AttackedSquare, AttackedCenterSquare, CenterPiece,
+			KnightOutpost, KnightDefendedByPawn, KnightUnderDeveloped, BishopUnderDeveloped
+		};
+
+		// in the order of Pieces.h
+		constexpr int materialTerms = 12;
+		constexpr std::array<int, materialTerms / 2> materialPieces = {
+			Piece::Rook, Piece::Knight, Piece::Bishop, Piece::Queen, Piece::King, Piece::Pawn
+		};
+
+		// king zone attacks per attacked square, indexed like Pieces.h without the color
+		constexpr std::array<int, 7> kingAttackWeights = { 0, 3, 2, 2, 5, 0, 0 };
+		constexpr int maxKingAttackers = 4;
+
+		static_assert(pawnTerms % 4 == 0 && pieceTerms % 4 == 0 && materialTerms % 4 == 0);
+
+		template <size_t N>
+		consteval std::array<Score, 2 * N> colorWeights(const std::array<Parameter, N>& parameters)
+		{
+			std::array<Score, 2 * N> weights{};
+
+			for (size_t i = 0; i < N; i++)
+			{
+				weights[2 * i] = evaluationWeights[parameters[i]];
+				weights[2 * i + 1] = -evaluationWeights[parameters[i]];
+			}
 
-		bonus += std::popcount(promotionRow & pawns) * passedPawnBonus;
-		pawns &= ~promotionRow;
+			return weights;
+		}
 
-		while (pawns)
+		consteval std::array<int32_t, materialTerms> makeMaterialWeights()
 		{
-			int square = std::countr_zero(pawns);
-			uint64_t passedPawnMask = passedPawnTables[colorIndex][square];
-			
-			if ((passedPawnMask & enemyPawns) == 0ULL)
+			std::array<int32_t, materialTerms> weights{};
+
+			for (int i = 0; i < materialTerms / 2; i++)
 			{
-				bonus += passedPawnBonus;
+				weights[2 * i] = pieceValues[materialPieces[i]];
+				weights[2 * i + 1] = -pieceValues[materialPieces[i]];
 			}
 
-			pawns &= (pawns - 1);
+			return weights;
 		}
 
-		return bonus;
+		constexpr std::array<Score, pawnTerms> pawnWeights = colorWeights(pawnParameters);
+		constexpr std::array<Score, pieceTerms> pieceWeights = colorWeights(pieceParameters);
+		constexpr std::array<int32_t, materialTerms> materialWeights = makeMaterialWeights();
+
+		// Everything the evaluation of the pieces counts besides material, the scalar terms are already white minus black
+		struct PieceFeatures
+		{
+			std::array<uint64_t, pieceTerms> terms;
+
+			int knightPawns;
+			int bishopPairs;
+			int rooksOnOpenFiles;
+			int rooksDefendingEachOther;
+
+			// indexed like Pieces.h without the color, only knights, bishops, rooks and queens are counted
+			std::array<int, 7> mobility;
+			int kingAttack;
+		};
+
+		// Mobility and king attacks of one side
+		struct Activity
+		{
+			std::array<int, 7> mobility{};
+			int kingAttack = 0;
+		};
+	}
+
+	// doubled, passed, isolated and connected pawns
+	std::array<uint64_t, pawnTerms> gatherPawnTerms(uint64_t whitePawns, uint64_t blackPawns, const PawnEntry& entry)
+	{
+		return {
+			whitePawns & (whitePawns >> 8), blackPawns & (blackPawns << 8),
+			entry.passedPawns[1], entry.passedPawns[0],
+			findIsolatedPawns(whitePawns), findIsolatedPawns(blackPawns),
+			findConnectedPawns(whitePawns), findConnectedPawns(blackPawns)
+		};
+	}
+
+	int countKnightPawns(uint64_t knights, uint64_t pawns)
+	{
+		return std::popcount(pawns) * std::popcount(knights);
+	}
+
+	int countBishopPair(uint64_t bishops)
+	{
+		return std::popcount(bishops) > 1 ? 1 : 0;
 	}
 
-	int applyIsolatedPawns(uint64_t pawns)
+	int countRooksOnOpenFiles(uint64_t rooks, uint64_t occupiedSquares)
 	{
-		int penalty = 0;
+		int count = 0;
 
-		// create pawns full as we change pawns when iterating
-		uint64_t pawnsFull = pawns;
+		occupiedSquares &= ~rooks;
 
-		while (pawns)
+		while (rooks)
 		{
-			int pawnIndex = std::countr_zero(pawns);
-			int col = pawnIndex % 8;
+			int col = std::countr_zero(rooks) % 8;
 
-			if ((isolatedPawnTable[col] & pawnsFull) == 0ULL)
+			if ((filesTable[col] & occupiedSquares) == 0ULL)
 			{
-				penalty += isolatedPawnPenalty;
+				count++;
 			}
-
-			pawns &= (pawns - 1);
+			rooks &= (rooks - 1);
 		}
-		
-		return penalty;
+
+		return count;
 	}
 
-	int applyDefenderPawns(uint64_t pawns, uint64_t ocupiedSquares, bool white)
+	int countRooksDefendingEachOther(uint64_t rooks)
 	{
-		int evaluation = 0;
-		uint64_t defendedSquares = ChessBoard::getThreatMapforPawn(pawns, white);
-		
-		evaluation += std::popcount(ocupiedSquares & defendedSquares) * defenderBonus;
+		uint64_t anyRookIndex = std::countr_zero(rooks);
+		uint64_t rookFile = anyRookIndex % 8;
+		uint64_t rookRank = anyRookIndex / 8;
 
-		return evaluation;
+		return (std::popcount(rookRank & rooks) > 1 || std::popcount(rookFile & rooks) > 1) ? 1 : 0;
 	}
-	
-	int applyConnectedPawns(uint64_t pawns)
+
+	// the king and the squares around it
+	uint64_t findKingZone(uint64_t king)
 	{
-		uint64_t pawnsFull = pawns;
-		pawns &= ~Consts::COL8;
-	
-		// shift pawns 1 to the right and check if there is another pawn
-		// therefore bonus for 2 connected pawns in 20, 3 - 40, 4 - 60....
-		return std::popcount((pawns << 1) & pawnsFull) * connectedPawnsBonus;
+		return king | ChessBoard::getThreatMapforKing(king);
 	}
 
-	int applyAttackedSquares(uint64_t threatMap)
+	Activity measureActivity(const AttackTable& attacks, uint64_t mobilityArea, uint64_t enemyKingZone)
 	{
-		const uint64_t center = 0b00000000'00000000'00111100'00111100'00111100'00111100'00000000'00000000;
-		const int attackedCenterSquareBonus = 3;
+		Activity activity;
+		int attackers = 0;
+		int attackUnits = 0;
+
+		for (int i = 0; i < attacks.pieceCount; i++)
+		{
+			int type = attacks.pieceTypes[i];
+			uint64_t zoneAttacks = attacks.pieceAttacks[i] & enemyKingZone;
+
+			activity.mobility[type] += std::popcount(attacks.pieceAttacks[i] & mobilityArea);
+
+			if (zoneAttacks)
+			{
+				attackers++;
+				attackUnits += kingAttackWeights[type] * std::popcount(zoneAttacks);
+			}
+		}
+
+		// a lone attacker is rarely dangerous, every piece joining the attack makes it more so
+		activity.kingAttack = attackUnits * std::min(attackers, maxKingAttackers);
 
-		int evaluation = 0;
+		return activity;
+	}
+
+	std::array<uint64_t, materialTerms> gatherMaterial(const std::array<uint64_t, 15>& bitboards)
+	{
+		std::array<uint64_t, materialTerms> material;
 
-		evaluation += std::popcount(threatMap & ~center) * attackedSquaresBonus;
-		evaluation += std::popcount(threatMap & center) * attackedCenterSquareBonus;
+		for (int i = 0; i < materialTerms / 2; i++)
+		{
+			material[2 * i] = bitboards[materialPieces[i]];
+			material[2 * i + 1] = bitboards[materialPieces[i] | Piece::Black];
+		}
 
-		return evaluation;
+		return material;
 	}
 
-	int applyKnightBonuses(uint64_t knights, uint64_t friendlyPawns, uint64_t enemyPawns, bool white)
+	PieceFeatures gatherPieceFeatures(const ChessBoard& chessBoard, const PawnEntry& pawns)
 	{
-		const int knightOutPostBonus = 40;
-		const int lotPawnsBonus = 3;
-		const int defendedByPawnBonus = 20;
+		const uint64_t center = 0b00000000'00000000'00111100'00111100'00111100'00111100'00000000'00000000;
+		const uint64_t backRanks = Consts::ROW1 | Consts::ROW8;
+
+		uint64_t occupiedSquaresWhite = chessBoard.getOccupiedSquares(true);
+		uint64_t occupiedSquaresBlack = chessBoard.getOccupiedSquares(false);
+		uint64_t occupiedSquares = occupiedSquaresBlack | occupiedSquaresWhite;
+
+		// cached by the board, the move generation of this position reuses them
+		const AttackTable& attacksWhite = chessBoard.getAttackTable(true);
+		const AttackTable& attacksBlack = chessBoard.getAttackTable(false);
+
+		uint64_t threatMapWhite = attacksWhite.all;
+		uint64_t threatMapBlack = attacksBlack.all;
+
+		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+		uint64_t allPawns = bitboards[Piece::WhitePawn] | bitboards[Piece::BlackPawn];
+
+		PieceFeatures features;
 
-		const int underDevelopedPenalty = 25;
-		const int pawnsForPenalty = 14;
+		features.terms = {
+			pawns.pawnAttacks[1] & occupiedSquaresWhite, pawns.pawnAttacks[0] & occupiedSquaresBlack,
+			threatMapWhite & ~center, threatMapBlack & ~center,
+			threatMapWhite & center, threatMapBlack & center,
+			occupiedSquaresWhite & center, occupiedSquaresBlack & center,
+			bitboards[Piece::WhiteKnight] & pawns.outposts[1], bitboards[Piece::BlackKnight] & pawns.outposts[0],
+			bitboards[Piece::WhiteKnight] & pawns.pawnAttacks[1], bitboards[Piece::BlackKnight] & pawns.pawnAttacks[0],
+			bitboards[Piece::WhiteKnight] & backRanks, bitboards[Piece::BlackKnight] & backRanks,
+			bitboards[Piece::WhiteBishop] & backRanks, bitboards[Piece::BlackBishop] & backRanks
+		};
 
-		int colorIndex = int(white);
-		int evaluation = 0;
+		features.knightPawns = countKnightPawns(bitboards[Piece::WhiteKnight], allPawns) - countKnightPawns(bitboards[Piece::BlackKnight], allPawns);
+		features.bishopPairs = countBishopPair(bitboards[Piece::WhiteBishop]) - countBishopPair(bitboards[Piece::BlackBishop]);
 
-		uint64_t defendedSquares = ChessBoard::getThreatMapforPawn(friendlyPawns, white);
+		features.rooksOnOpenFiles = countRooksOnOpenFiles(bitboards[Piece::WhiteRook], occupiedSquares) - countRooksOnOpenFiles(bitboards[Piece::BlackRook], occupiedSquares);
+		features.rooksDefendingEachOther = countRooksDefendingEachOther(bitboards[Piece::WhiteRook]) - countRooksDefendingEachOther(bitboards[Piece::BlackRook]);
 
-		evaluation -= (pawnsForPenalty - ((std::popcount(friendlyPawns | enemyPawns)) * std::popcount(knights))) * lotPawnsBonus;
-		evaluation += std::popcount(knights & defendedSquares) * defendedByPawnBonus;
+		// squares not taken by own pawns or the king and not attacked by enemy pawns
+		uint64_t mobilityAreaWhite = ~(bitboards[Piece::WhitePawn] | bitboards[Piece::WhiteKing] | pawns.pawnAttacks[0]);
+		uint64_t mobilityAreaBlack = ~(bitboards[Piece::BlackPawn] | bitboards[Piece::BlackKing] | pawns.pawnAttacks[1]);
 
-		evaluation -= std::popcount(knights & (Consts::ROW1 | Consts::ROW8)) * underDevelopedPenalty;
+		Activity activityWhite = measureActivity(attacksWhite, mobilityAreaWhite, findKingZone(bitboards[Piece::BlackKing]));
+		Activity activityBlack = measureActivity(attacksBlack, mobilityAreaBlack, findKingZone(bitboards[Piece::WhiteKing]));
 
-		while (knights)
+		for (size_t type = 0; type < features.mobility.size(); type++)
 		{
-			// Check for the outpost using passedPawnTable
-			if ((passedPawnTables[colorIndex][std::countr_zero(knights)] & enemyPawns) == 0ULL)
-			{
-				evaluation += knightOutPostBonus;
-			}
-			knights &= (knights - 1);
+			features.mobility[type] = activityWhite.mobility[type] - activityBlack.mobility[type];
 		}
+		features.kingAttack = activityWhite.kingAttack - activityBlack.kingAttack;
 
-		return evaluation;
+		return features;
 	}
 
-	int applyBishopBonuses(uint64_t bishops)
+	template <WeightedPopcount popcountKernel>
+	PawnEntry computePawnEntry(uint64_t whitePawns, uint64_t blackPawns)
 	{
-		const int bishopPairBonus = 70;
-		const int underDevelopedPenalty = 25;
+		PawnEntry entry;
+		entry.whitePawns = whitePawns;
+		entry.blackPawns = blackPawns;
+
+		entry.outposts[1] = findOutposts(blackPawns, true);
+		entry.outposts[0] = findOutposts(whitePawns, false);
 
-		int evaluation = 0;
+		entry.passedPawns[1] = whitePawns & entry.outposts[1];
+		entry.passedPawns[0] = blackPawns & entry.outposts[0];
 
-		if (std::popcount(bishops) > 1) evaluation += bishopPairBonus;
+		entry.pawnAttacks[1] = ChessBoard::getThreatMapforPawn(whitePawns, true);
+		entry.pawnAttacks[0] = ChessBoard::getThreatMapforPawn(blackPawns, false);
 
-		evaluation -= std::popcount(bishops & (Consts::ROW1 | Consts::ROW8)) * underDevelopedPenalty;
+		alignas(32) const std::array<uint64_t, pawnTerms> terms = gatherPawnTerms(whitePawns, blackPawns, entry);
 
-		return evaluation;
+		entry.score = popcountKernel(terms.data(), pawnWeights.data(), pawnTerms);
+		return entry;
 	}
 
-	int applyRookBonuses(uint64_t rooks, uint64_t occupiedSquares)
+	PawnEntry evaluatePawns(uint64_t whitePawns, uint64_t blackPawns)
 	{
-		const int rookOnOpenFileBonus = 39;
-		const int defendingEachOtherBonus = 50;
-		int evaluation = 0;
+		return computePawnEntry<weightedPopcount>(whitePawns, blackPawns);
+	}
 
-		occupiedSquares &= ~rooks;
+	int interpolate(Score score, int gamePhase)
+	{
+		return (mgValue(score) * gamePhase + egValue(score) * (maxGamePhase - gamePhase)) / maxGamePhase;
+	}
 
-		uint64_t anyRookIndex = std::countr_zero(rooks);
-		uint64_t rookFile = anyRookIndex % 8;
-		uint64_t rookRank = anyRookIndex / 8;
+	int scaleEvaluation(int evaluation, const Endgames::Endgame& endgame, const ChessBoard& chessBoard, const PawnEntry& pawns)
+	{
+		return evaluation * Endgames::scaleFor(endgame, chessBoard, pawns, evaluation) / Endgames::normalScale;
+	}
+
+	// Evaluation of a position that is not over, pawn structure terms come from the entry. Specialized endgames
+	// are evaluated by the registry, otherwise material, piece-square tables and pawns are evaluated first,
+	// if they are not above lazyLow or not below lazyHigh the rest (which needs the attack tables of both sides)
+	// is skipped and lazy is set
+	template <WeightedPopcount popcountKernel>
+	int evaluatePieces(const ChessBoard& chessBoard, const PawnEntry& pawns, int lazyLow, int lazyHigh, bool& lazy)
+	{
+		const EvalAccumulator& accumulator = chessBoard.getAccumulator();
+		Endgames::Endgame endgame = Endgames::probe(accumulator.materialKey);
 
-		if (std::popcount(rookRank & rooks) > 1 || std::popcount(rookFile & rooks) > 1)
+		if (endgame.evaluate)
 		{
-			evaluation += defendingEachOtherBonus;
+			return endgame.evaluate(chessBoard, endgame.strongWhite);
 		}
 
-		while (rooks)
-		{
-			int col = std::countr_zero(rooks) % 8;
+		alignas(32) const std::array<uint64_t, materialTerms> pieces = gatherMaterial(chessBoard.getBitboards());
 
-			if ((filesTable[col] & occupiedSquares) == 0ULL)
-			{
-				evaluation += rookOnOpenFileBonus;
-			}
-			rooks &= (rooks - 1);
+		int material = popcountKernel(pieces.data(), materialWeights.data(), materialTerms);
+		int gamePhase = calculateGamePhase(chessBoard);
+
+		Score score = makeScore(accumulator.mgPST, accumulator.egPST) + pawns.score;
+
+		int cheapEvaluation = scaleEvaluation(material + interpolate(score, gamePhase), endgame, chessBoard, pawns);
+		if (cheapEvaluation <= lazyLow || cheapEvaluation >= lazyHigh)
+		{
+			lazy = true;
+			return cheapEvaluation;
 		}
 
-		return evaluation;
+		alignas(32) const PieceFeatures features = gatherPieceFeatures(chessBoard, pawns);
+
+		// pieces defended by a pawn, attacked squares, center occupancy, knight outposts,
+		// knights defended by a pawn and undeveloped minor pieces in one pass
+		score += popcountKernel(features.terms.data(), pieceWeights.data(), pieceTerms);
+
+		score += features.knightPawns * evaluationWeights[KnightPawns];
+		score += features.bishopPairs * evaluationWeights[BishopPair];
+		score += features.rooksOnOpenFiles * evaluationWeights[RookOnOpenFile];
+		score += features.rooksDefendingEachOther * evaluationWeights[RooksDefendingEachOther];
+
+		score += features.mobility[Piece::Knight] * evaluationWeights[KnightMobility];
+		score += features.mobility[Piece::Bishop] * evaluationWeights[BishopMobility];
+		score += features.mobility[Piece::Rook] * evaluationWeights[RookMobility];
+		score += features.mobility[Piece::Queen] * evaluationWeights[QueenMobility];
+		score += features.kingAttack * evaluationWeights[KingAttack];
+
+		// single interpolation between the midgame and endgame scores
+		return scaleEvaluation(material + interpolate(score, gamePhase), endgame, chessBoard, pawns);
 	}
 
-	int applyOccupiedCenter(uint64_t occupiedSquares)
+	template <WeightedPopcount popcountKernel>
+	int evaluatePieces(const ChessBoard& chessBoard, const PawnEntry& pawns)
 	{
-		const int CenterPieceBonus = 8;
-		const uint64_t center = 0b00000000'00000000'00111100'00111100'00111100'00111100'00000000'00000000;
+		bool lazy = false;
+		return evaluatePieces<popcountKernel>(chessBoard, pawns, NegInfinity, PosInfinity, lazy);
+	}
 
-		return std::popcount(center & occupiedSquares) * CenterPieceBonus;
+	template <size_t N>
+	void addCoefficients(Trace& trace, const std::array<uint64_t, 2 * N>& terms, const std::array<Parameter, N>& parameters)
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			trace.coefficients[parameters[i]] += std::popcount(terms[2 * i]) - std::popcount(terms[2 * i + 1]);
+		}
 	}
 
-	// specific for endgames
-	int forceKingToCorner(uint64_t king, uint64_t opponentKing)
+	Trace traceEvaluation(const ChessBoard& chessBoard)
 	{
-		int evaluation = 0;
+		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+		PawnEntry pawns = evaluatePawns(bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn]);
+		PieceFeatures features = gatherPieceFeatures(chessBoard, pawns);
+
+		Trace trace;
 
-		int friendlyIndex = std::countr_zero(king);
-		int opponentIndex = std::countr_zero(opponentKing);
+		addCoefficients(trace, gatherPawnTerms(bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn], pawns), pawnParameters);
+		addCoefficients(trace, features.terms, pieceParameters);
 
-		int opponentRank = opponentIndex / 8;
-		int opponentFile = opponentIndex % 8;
+		trace.coefficients[PawnValue] = std::popcount(bitboards[Piece::WhitePawn]) - std::popcount(bitboards[Piece::BlackPawn]);
+		trace.coefficients[KnightValue] = std::popcount(bitboards[Piece::WhiteKnight]) - std::popcount(bitboards[Piece::BlackKnight]);
+		trace.coefficients[BishopValue] = std::popcount(bitboards[Piece::WhiteBishop]) - std::popcount(bitboards[Piece::BlackBishop]);
+		trace.coefficients[RookValue] = std::popcount(bitboards[Piece::WhiteRook]) - std::popcount(bitboards[Piece::BlackRook]);
+		trace.coefficients[QueenValue] = std::popcount(bitboards[Piece::WhiteQueen]) - std::popcount(bitboards[Piece::BlackQueen]);
 
-		// force opponent king to the corner
-		int opponentDistanceCenterFile = std::max(3 - opponentFile, opponentFile - 4);
-		int opponentDistanceCenterRank = std::max(3 - opponentRank, opponentRank - 4);
-		int opponentDistanceFromCenter = opponentDistanceCenterFile + opponentDistanceCenterRank;
-		evaluation += opponentDistanceFromCenter;
+		trace.coefficients[KnightPawns] = features.knightPawns;
+		trace.coefficients[BishopPair] = features.bishopPairs;
+		trace.coefficients[RookOnOpenFile] = features.rooksOnOpenFiles;
+		trace.coefficients[RooksDefendingEachOther] = features.rooksDefendingEachOther;
 
-		// distance between kings
-		int friendlyRank = friendlyIndex / 8;
-		int friendlyFile = friendlyIndex % 8;
+		trace.coefficients[KnightMobility] = features.mobility[Piece::Knight];
+		trace.coefficients[BishopMobility] = features.mobility[Piece::Bishop];
+		trace.coefficients[RookMobility] = features.mobility[Piece::Rook];
+		trace.coefficients[QueenMobility] = features.mobility[Piece::Queen];
+		trace.coefficients[KingAttack] = features.kingAttack;
 
-		int distanceRank = std::abs(friendlyRank - opponentRank);
-		int distanceFile = std::abs(friendlyFile - opponentFile);
-		int distanceKings = distanceFile + distanceRank;
+		trace.mgBase = chessBoard.getAccumulator().mgPST;
+		trace.egBase = chessBoard.getAccumulator().egPST;
+		trace.gamePhase = calculateGamePhase(chessBoard);
 
-		evaluation += 15 - (distanceFile + distanceRank);
+		Endgames::Endgame endgame = Endgames::probe(chessBoard.getAccumulator().materialKey);
+		trace.specialized = endgame.evaluate != nullptr;
+		trace.scale = Endgames::scaleFor(endgame, chessBoard, pawns, evaluateTrace(trace, evaluationWeights));
 
-		return evaluation * 10;
+		return trace;
 	}
 
-	int EvaluatePositionStatic(const ChessBoard& chessBoard)
+	int evaluateTrace(const Trace& trace, const std::array<Score, ParameterCount>& weights)
 	{
-		GameState boardState = chessBoard.getGameState();
-		bool gameOver = boardState.isGameOver();
-
-		uint64_t occupiedSquaresWhite = chessBoard.getOccupiedSquares(true);
-		uint64_t occupiedSquaresBlack = chessBoard.getOccupiedSquares(false);
-		uint64_t occupiedSquares = occupiedSquaresBlack | occupiedSquaresWhite;
+		int material = 0;
+		int mg = trace.mgBase;
+		int eg = trace.egBase;
 
-		if (gameOver)
+		for (int i = 0; i < materialParameters; i++)
 		{
-			if (boardState.whiteWon())
-			{
-				return PosInfinity;
-			}
-			else if (boardState.blackWon())
-			{
-				return NegInfinity;
-			}
-
-			return 0;
+			material += trace.coefficients[i] * mgValue(weights[i]);
 		}
 
-		int evaluation = 0;
-		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
-
-		// float from 0 to 1, where 1 is start and 0 is end
-		float gamePhase = calculateGamePhase(chessBoard);
+		for (int i = materialParameters; i < ParameterCount; i++)
+		{
+			mg += trace.coefficients[i] * mgValue(weights[i]);
+			eg += trace.coefficients[i] * egValue(weights[i]);
+		}
 
-		int startWhite = Piece::WhiteRook;
-		int endWhite = Piece::WhitePawn;
+		int evaluation = material + (mg * trace.gamePhase + eg * (maxGamePhase - trace.gamePhase)) / maxGamePhase;
 
-		int startBlack = Piece::BlackRook;
-		int endBlack = Piece::BlackPawn;
+		return evaluation * trace.scale / Endgames::normalScale;
+	}
 
-		for (int i = startWhite; i <= endWhite; i++)
+	int evaluateGameOver(const GameState& boardState)
+	{
+		if (boardState.whiteWon())
 		{
-			evaluation += std::popcount(bitboards[i]) * pieceValues[i];
-
-			evaluation += gamePhase * (float)applyPSTWhite(bitboards[i], Evaluation::mg_pestoTable[i]);
-			evaluation += (1.0f - gamePhase) * (float)applyPSTWhite(bitboards[i], Evaluation::eg_pestoTable[i]);
+			return PosInfinity;
 		}
-
-		for (int i = startBlack; i <= endBlack; i++)
+		else if (boardState.blackWon())
 		{
-			evaluation -= std::popcount(bitboards[i]) * pieceValues[i - Piece::Black];
-
-			evaluation -= gamePhase * (float)applyPSTBlack(bitboards[i], Evaluation::mg_pestoTable[i - Piece::Black]);
-			evaluation -= (1.0f - gamePhase) * (float)applyPSTBlack(bitboards[i], Evaluation::eg_pestoTable[i - Piece::Black]);
+			return NegInfinity;
 		}
 
-		// apply penalties for doubled pawns
-		evaluation -= std::popcount(bitboards[Piece::WhitePawn] & (bitboards[Piece::WhitePawn] >> 8)) * doubledPawnPenalty;
-		evaluation += std::popcount(bitboards[Piece::BlackPawn] & (bitboards[Piece::BlackPawn] << 8)) * doubledPawnPenalty;
+		return 0;
+	}
 
-		// apply bonuses for passed pawns
-		evaluation += (1.0f - gamePhase) * applyPassedPawns(bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn], true);
-		evaluation -= (1.0f - gamePhase) * applyPassedPawns(bitboards[Piece::BlackPawn], bitboards[Piece::WhitePawn], false);
+	int EvaluatePositionStatic(const ChessBoard& chessBoard)
+	{
+		GameState boardState = chessBoard.getGameState();
 
-		// apply penalties for isolated pawns 
-		evaluation -= gamePhase * applyIsolatedPawns(bitboards[Piece::WhitePawn]);
-		evaluation += gamePhase * applyIsolatedPawns(bitboards[Piece::BlackPawn]);
+		if (boardState.isGameOver())
+		{
+			return evaluateGameOver(boardState);
+		}
 
-		// apply bonuses for every piece defended by a pawn
-		evaluation += gamePhase * applyDefenderPawns(bitboards[Piece::WhitePawn], occupiedSquaresWhite, true);
-		evaluation -= gamePhase * applyDefenderPawns(bitboards[Piece::BlackPawn], occupiedSquaresBlack, false);
+		return evaluatePieces<weightedPopcount>(chessBoard, evaluatePawns(chessBoard.getBitboards()[Piece::WhitePawn], chessBoard.getBitboards()[Piece::BlackPawn]));
+	}
 
-		// apply bonuses for connected pawns
-		evaluation += gamePhase * applyConnectedPawns(bitboards[Piece::WhitePawn]);
-		evaluation -= gamePhase * applyConnectedPawns(bitboards[Piece::BlackPawn]);
+	int EvaluatePositionStatic(const ChessBoard& chessBoard, PawnHashTable& pawnHash)
+	{
+		GameState boardState = chessBoard.getGameState();
 
-		// bonuses for attacked squares
-		evaluation += gamePhase * applyAttackedSquares(chessBoard.getThreatMap(true));
-		evaluation -= gamePhase * applyAttackedSquares(chessBoard.getThreatMap(false));
+		if (boardState.isGameOver())
+		{
+			return evaluateGameOver(boardState);
+		}
 
-		// apply knight bonuses and penalties (outpost, low pawn number)
-		evaluation += applyKnightBonuses(bitboards[Piece::WhiteKnight], bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn], true);
-		evaluation -= applyKnightBonuses(bitboards[Piece::BlackKnight], bitboards[Piece::BlackPawn], bitboards[Piece::WhitePawn], false);
+		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+		const PawnEntry& pawns = pawnHash.probe(chessBoard.getAccumulator().pawnKey, bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn]);
 
-		// apply bishop bonuses
-		evaluation += applyBishopBonuses(bitboards[Piece::WhiteBishop]);
-		evaluation -= applyBishopBonuses(bitboards[Piece::BlackBishop]);
+		return evaluatePieces<weightedPopcount>(chessBoard, pawns);
+	}
 
-		// apply rook bonuses
-		evaluation += applyRookBonuses(bitboards[Piece::WhiteRook], occupiedSquares);
-		evaluation -= applyRookBonuses(bitboards[Piece::BlackRook], occupiedSquares);
+	int EvaluatePositionStaticScalar(const ChessBoard& chessBoard)
+	{
+		GameState boardState = chessBoard.getGameState();
 
-		// force opponent king to corner
-		int kingToCenterBonus = (1.0f - gamePhase) * forceKingToCorner(bitboards[Piece::WhiteKing], bitboards[Piece::BlackKing]);
-		
-		evaluation += chessBoard.isWhiteToMove() ? kingToCenterBonus : -kingToCenterBonus;
+		if (boardState.isGameOver())
+		{
+			return evaluateGameOver(boardState);
+		}
 
-		evaluation += gamePhase * applyOccupiedCenter(occupiedSquaresWhite);
-		evaluation -= gamePhase * applyOccupiedCenter(occupiedSquaresBlack);
+		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+		PawnEntry pawns = computePawnEntry<weightedPopcountScalar>(bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn]);
 
-		return evaluation;
+		return evaluatePieces<weightedPopcountScalar>(chessBoard, pawns);
 	}
 
-	int Evaluation::EvaluatePosition(const ChessBoard& chessBoard)
+	int EvaluatePosition(const ChessBoard& chessBoard)
 	{
 		return chessBoard.isWhiteToMove() ?
 			EvaluatePositionStatic(chessBoard) :
 			-EvaluatePositionStatic(chessBoard);
 	}
-}
\ No newline at end of file
+
+	int EvaluatePosition(const ChessBoard& chessBoard, PawnHashTable& pawnHash)
+	{
+		return chessBoard.isWhiteToMove() ?
+			EvaluatePositionStatic(chessBoard, pawnHash) :
+			-EvaluatePositionStatic(chessBoard, pawnHash);
+	}
+
+	int EvaluatePosition(const ChessBoard& chessBoard, PawnHashTable& pawnHash, int lazyLow, int lazyHigh, bool& lazy)
+	{
+		GameState boardState = chessBoard.getGameState();
+		bool white = chessBoard.isWhiteToMove();
+
+		if (boardState.isGameOver())
+		{
+			return white ? evaluateGameOver(boardState) : -evaluateGameOver(boardState);
+		}
+
+		std::array<uint64_t, 15> bitboards = chessBoard.getBitboards();
+		const PawnEntry& pawns = pawnHash.probe(chessBoard.getAccumulator().pawnKey, bitboards[Piece::WhitePawn], bitboards[Piece::BlackPawn]);
+
+		// the bounds are for the side to move, the pieces are evaluated for white
+		return white ?
+			evaluatePieces<weightedPopcount>(chessBoard, pawns, lazyLow, lazyHigh, lazy) :
+			-evaluatePieces<weightedPopcount>(chessBoard, pawns, -lazyHigh, -lazyLow, lazy);
+	}
+}
@@ -1,9 +1,19 @@
 #pragma once
 
 #include "ChessBoard.h"
+#include "Endgames.h"
+#include "EvaluationWeights.h"
 #include <cassert>
+#include <cstdint>
+#include <string_view>
 
 
+namespace Chess
+{
+	struct PawnEntry;
+	class PawnHashTable;
+}
+
 namespace Chess::Evaluation
 {
 	// black table on index 0, white ttable on index 1
@@ -120,29 +130,177 @@ namespace Chess::Evaluation
 	static constexpr int PosInfinity = INT32_MAX - 100;
 	static constexpr int NegInfinity = INT32_MIN + 100;
 
-	static constexpr int passedPawnBonus = 110;
-	static constexpr int isolatedPawnPenalty = 35;
-	static constexpr int doubledPawnPenalty = 30;
-	static constexpr int defenderBonus = 11;
-	static constexpr int connectedPawnsBonus = 6;
-	static constexpr int attackedSquaresBonus = 2;
+	// Midgame score in the low and endgame score in the high 16 bits, both are added and
+	// subtracted at once and interpolated by the game phase at the end of the evaluation
+	using Score = int32_t;
+
+	constexpr Score makeScore(int mg, int eg)
+	{
+		return static_cast<Score>(static_cast<uint32_t>(eg) << 16) + mg;
+	}
+
+	constexpr int mgValue(Score score)
+	{
+		return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score)));
+	}
+
+	// a negative midgame value borrows one from the endgame half, rounding gives it back
+	constexpr int egValue(Score score)
+	{
+		return static_cast<int16_t>(static_cast<uint16_t>((static_cast<uint32_t>(score) + 0x8000) >> 16));
+	}
+
+	static_assert(mgValue(makeScore(-5, 7)) == -5 && egValue(makeScore(-5, 7)) == 7);
+	static_assert(mgValue(makeScore(3, -9) - makeScore(8, 2)) == -5 && egValue(makeScore(3, -9) - makeScore(8, 2)) == -11);
+
+	// Tunable parameters, the indices of the weight vector. Weights are from white's point of view
+	// (penalties are negative), terms of black's pieces are subtracted
+	enum Parameter
+	{
+		// material, only the midgame value is used
+		PawnValue,
+		KnightValue,
+		BishopValue,
+		RookValue,
+		QueenValue,
+
+		DoubledPawn,
+		PassedPawn,
+		IsolatedPawn,
+		ConnectedPawn,
+		PawnDefender,			// per piece defended by a pawn
+		AttackedSquare,
+		AttackedCenterSquare,
+		CenterPiece,
+		KnightOutpost,
+		KnightDefendedByPawn,
+		KnightUnderDeveloped,
+		KnightPawns,			// per knight and pawn on the board
+		BishopUnderDeveloped,
+		BishopPair,
+		RookOnOpenFile,
+		RooksDefendingEachOther,
+		KnightMobility,			// per attacked square not occupied by own pawns or king and not attacked by enemy pawns
+		BishopMobility,
+		RookMobility,
+		QueenMobility,
+		KingAttack,				// weighted attacks on the enemy king zone, times the number of attackers
+
+		ParameterCount
+	};
+
+	static constexpr int materialParameters = QueenValue + 1;
+
+	// Names of the generated weights header
+	static constexpr std::array<std::string_view, ParameterCount> parameterNames = {
+		"PawnValue", "KnightValue", "BishopValue", "RookValue", "QueenValue",
+		"DoubledPawn", "PassedPawn", "IsolatedPawn", "ConnectedPawn",
+		"PawnDefender", "AttackedSquare", "AttackedCenterSquare", "CenterPiece",
+		"KnightOutpost", "KnightDefendedByPawn", "KnightUnderDeveloped", "KnightPawns",
+		"BishopUnderDeveloped", "BishopPair", "RookOnOpenFile", "RooksDefendingEachOther",
+		"KnightMobility", "BishopMobility", "RookMobility", "QueenMobility", "KingAttack"
+	};
+
+	// Hand-set starting point of the tuner, midgame and endgame weight of every parameter. A new parameter
+	// gets its starting weight here, the engine uses these until chess-tune regenerates EvaluationWeights.h
+	static constexpr std::array<std::array<int, 2>, ParameterCount> initialWeights = { {
+		{ 105, 105 },	// PawnValue
+		{ 320, 320 },	// KnightValue
+		{ 350, 350 },	// BishopValue
+		{ 500, 500 },	// RookValue
+		{ 900, 900 },	// QueenValue
+		{ -30, -30 },	// DoubledPawn
+		{ 0, 110 },		// PassedPawn
+		{ -35, 0 },		// IsolatedPawn
+		{ 6, 0 },		// ConnectedPawn
+		{ 11, 0 },		// PawnDefender
+		{ 2, 0 },		// AttackedSquare
+		{ 3, 0 },		// AttackedCenterSquare
+		{ 8, 0 },		// CenterPiece
+		{ 40, 40 },		// KnightOutpost
+		{ 20, 20 },		// KnightDefendedByPawn
+		{ -25, -25 },	// KnightUnderDeveloped
+		{ 3, 3 },		// KnightPawns
+		{ -25, -25 },	// BishopUnderDeveloped
+		{ 70, 70 },		// BishopPair
+		{ 39, 39 },		// RookOnOpenFile
+		{ 50, 50 },		// RooksDefendingEachOther
+		{ 4, 4 },		// KnightMobility
+		{ 5, 5 },		// BishopMobility
+		{ 2, 4 },		// RookMobility
+		{ 1, 2 },		// QueenMobility
+		{ 2, 0 },		// KingAttack
+	} };
+
+	// False while EvaluationWeights.h was generated for a different parameter list (the tuning test fails)
+	static constexpr bool hasTunedWeights = tunedWeights.size() == ParameterCount;
+
+	consteval std::array<Score, ParameterCount> makeWeights()
+	{
+		std::array<Score, ParameterCount> weights{};
+
+		for (int i = 0; i < ParameterCount; i++)
+		{
+			const std::array<int, 2>& weight = hasTunedWeights ? tunedWeights[i] : initialWeights[i];
+			weights[i] = makeScore(weight[0], weight[1]);
+		}
+
+		return weights;
+	}
+
+	static constexpr std::array<Score, ParameterCount> evaluationWeights = makeWeights();
 
 	// Matches the indices of Pieces.h
 	static constexpr std::array<int, 7> pieceValues = {
-		0,			// None
-		500,		// Rook
-		320,		// Knight
-		350,		// Bishop
-		900,		// Queen
-		10000,		// King
-		105			// Pawn
+		0,											// None
+		mgValue(evaluationWeights[RookValue]),		// Rook
+		mgValue(evaluationWeights[KnightValue]),	// Knight
+		mgValue(evaluationWeights[BishopValue]),	// Bishop
+		mgValue(evaluationWeights[QueenValue]),		// Queen
+		10000,										// King
+		mgValue(evaluationWeights[PawnValue])		// Pawn
+	};
+
+	// Coefficients of the parameters (white minus black) of a position that is not over, the evaluation is
+	// linear in the weights: material + ((mgBase + mg sum) * phase + (egBase + eg sum) * (maxGamePhase - phase)) / maxGamePhase,
+	// times scale / normalScale. Specialized endgames are evaluated without the weights
+	struct Trace
+	{
+		std::array<int, ParameterCount> coefficients{};
+		int mgBase = 0;		// piece-square tables, kept by the board and not tuned
+		int egBase = 0;
+		int gamePhase = 0;
+
+		int scale = Endgames::normalScale;	// of the side ahead with the traced weights
+		bool specialized = false;
 	};
 
-	float calculateGamePhase(const ChessBoard& chessBoard);
+	// Game phase from 0 (endgame) to maxGamePhase (opening)
+	static constexpr int maxGamePhase = 100;
+
+	int calculateGamePhase(const ChessBoard& chessBoard);
+
+	// Pawn structure terms, the same for every position with these pawns
+	PawnEntry evaluatePawns(uint64_t whitePawns, uint64_t blackPawns);
 
 	// Static (signed evaluation)
 	int EvaluatePositionStatic(const ChessBoard& chessBoard);
+	int EvaluatePositionStatic(const ChessBoard& chessBoard, PawnHashTable& pawnHash);
+
+	Trace traceEvaluation(const ChessBoard& chessBoard);
+
+	// Static evaluation of a trace with other weights, the same as EvaluatePositionStatic with evaluationWeights
+	// unless the endgame is specialized
+	int evaluateTrace(const Trace& trace, const std::array<Score, ParameterCount>& weights);
+
+	// Same as EvaluatePositionStatic with the portable kernels instead of the SIMD ones, for benchmarks and tests
+	int EvaluatePositionStaticScalar(const ChessBoard& chessBoard);
 
 	// Evaluation based on player to move
 	int EvaluatePosition(const ChessBoard& chessBoard);
+	int EvaluatePosition(const ChessBoard& chessBoard, PawnHashTable& pawnHash);
+
+	// Lazy evaluation, material, piece-square tables and pawn structure are evaluated first. If that is not above
+	// lazyLow or not below lazyHigh it is returned without the other terms and lazy is set
+	int EvaluatePosition(const ChessBoard& chessBoard, PawnHashTable& pawnHash, int lazyLow, int lazyHigh, bool& lazy);
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include <bit>
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EVALUATION_SSE2
+#endif
+
+#include "EvaluationKernels.h"
+
+namespace Chess::Evaluation
+{
+#if defined(__AVX2__)
+
+	// popcount of 4 bitboards at once, nibble lookup with shuffle and byte sums with sad
+	int32_t weightedPopcount(const uint64_t* bitboards, const int32_t* weights, size_t count)
+	{
+		assert(count % 4 == 0);
+
+		const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+		const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+		__m256i sum = _mm256_setzero_si256();
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitboards + i));
+
+			__m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(values, lowNibbles));
+			__m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(values, 4), lowNibbles));
+			__m256i counts = _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+
+			// only the low 32 bits of the products are used, so unsigned multiplication is fine
+			__m256i laneWeights = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			sum = _mm256_add_epi64(sum, _mm256_mul_epu32(counts, laneWeights));
+		}
+
+		__m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		sum128 = _mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128));
+
+		return static_cast<int32_t>(_mm_cvtsi128_si32(sum128));
+	}
+
+#elif defined(EVALUATION_SSE2)
+
+	// popcount of 2 bitboards at once, bit twiddling per byte and byte sums with sad
+	int32_t weightedPopcount(const uint64_t* bitboards, const int32_t* weights, size_t count)
+	{
+		assert(count % 4 == 0);
+
+		const __m128i m1 = _mm_set1_epi8(0x55);
+		const __m128i m2 = _mm_set1_epi8(0x33);
+		const __m128i m4 = _mm_set1_epi8(0x0f);
+		__m128i sum = _mm_setzero_si128();
+
+		for (size_t i = 0; i < count; i += 2)
+		{
+			__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bitboards + i));
+
+			values = _mm_sub_epi8(values, _mm_and_si128(_mm_srli_epi64(values, 1), m1));
+			values = _mm_add_epi8(_mm_and_si128(values, m2), _mm_and_si128(_mm_srli_epi64(values, 2), m2));
+			values = _mm_and_si128(_mm_add_epi8(values, _mm_srli_epi64(values, 4)), m4);
+			__m128i counts = _mm_sad_epu8(values, _mm_setzero_si128());
+
+			// only the low 32 bits of the products are used, so unsigned multiplication is fine
+			__m128i laneWeights = _mm_set_epi32(0, weights[i + 1], 0, weights[i]);
+			sum = _mm_add_epi64(sum, _mm_mul_epu32(counts, laneWeights));
+		}
+
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+
+		return static_cast<int32_t>(_mm_cvtsi128_si32(sum));
+	}
+
+#else
+
+	int32_t weightedPopcount(const uint64_t* bitboards, const int32_t* weights, size_t count)
+	{
+		return weightedPopcountScalar(bitboards, weights, count);
+	}
+
+#endif
+
+	int32_t weightedPopcountScalar(const uint64_t* bitboards, const int32_t* weights, size_t count)
+	{
+		assert(count % 4 == 0);
+
+		uint32_t sum = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			sum += static_cast<uint32_t>(std::popcount(bitboards[i])) * static_cast<uint32_t>(weights[i]);
+		}
+
+		return static_cast<int32_t>(sum);
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Chess::Evaluation
+{
+	// Sum of popcount(bitboards[i]) * weights[i], count has to be a multiple of 4.
+	// The sum wraps like unsigned arithmetic, so packed midgame/endgame scores work as weights.
+	// The SIMD version is chosen at compile time (AVX2, SSE2 or scalar)
+	int32_t weightedPopcount(const uint64_t* bitboards, const int32_t* weights, size_t count);
+	int32_t weightedPopcountScalar(const uint64_t* bitboards, const int32_t* weights, size_t count);
+
+	using WeightedPopcount = int32_t(*)(const uint64_t* bitboards, const int32_t* weights, size_t count);
+}
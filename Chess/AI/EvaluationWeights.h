@@ -0,0 +1,38 @@
+#pragma once
+
+// Generated by chess-tune, regenerate it instead of editing by hand.
+// Midgame and endgame weight of every Evaluation::Parameter, in the same order
+
+#include <array>
+
+namespace Chess::Evaluation
+{
+	static constexpr std::array<std::array<int, 2>, 26> tunedWeights = { {
+		{ 105, 105 },	// PawnValue
+		{ 320, 320 },	// KnightValue
+		{ 350, 350 },	// BishopValue
+		{ 500, 500 },	// RookValue
+		{ 900, 900 },	// QueenValue
+		{ -30, -30 },	// DoubledPawn
+		{ 0, 110 },	// PassedPawn
+		{ -35, 0 },	// IsolatedPawn
+		{ 6, 0 },	// ConnectedPawn
+		{ 11, 0 },	// PawnDefender
+		{ 2, 0 },	// AttackedSquare
+		{ 3, 0 },	// AttackedCenterSquare
+		{ 8, 0 },	// CenterPiece
+		{ 40, 40 },	// KnightOutpost
+		{ 20, 20 },	// KnightDefendedByPawn
+		{ -25, -25 },	// KnightUnderDeveloped
+		{ 3, 3 },	// KnightPawns
+		{ -25, -25 },	// BishopUnderDeveloped
+		{ 70, 70 },	// BishopPair
+		{ 39, 39 },	// RookOnOpenFile
+		{ 50, 50 },	// RooksDefendingEachOther
+		{ 4, 4 },	// KnightMobility
+		{ 5, 5 },	// BishopMobility
+		{ 2, 4 },	// RookMobility
+		{ 1, 2 },	// QueenMobility
+		{ 2, 0 },	// KingAttack
+	} };
+}
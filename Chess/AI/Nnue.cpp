@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNUE_SSE2
+#endif
+
+#include "Nnue.h"
+
+namespace Chess::Nnue
+{
+	namespace
+	{
+		template <typename T>
+		bool readArray(std::istream& in, T* data, size_t count)
+		{
+			return static_cast<bool>(in.read(reinterpret_cast<char*>(data), sizeof(T) * count));
+		}
+
+		template <typename T>
+		bool writeArray(std::ostream& out, const T* data, size_t count)
+		{
+			return static_cast<bool>(out.write(reinterpret_cast<const char*>(data), sizeof(T) * count));
+		}
+
+		// feature of a piece seen by one perspective, black sees the board flipped
+		int featureIndex(int perspective, int piece, int square)
+		{
+			bool white = !(piece & Piece::Black);
+			int relativeColor = (white == static_cast<bool>(perspective)) ? 0 : 1;
+			int relativeSquare = perspective ? square : square ^ 56;
+
+			return ((relativeColor * 6 + (piece & ~Piece::Black) - Piece::Rook) * 64 + relativeSquare) * hiddenSize;
+		}
+	}
+
+	std::unique_ptr<Network> Network::load(const std::string& fileName)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		uint32_t header[3] = {};
+
+		if (!file || !readArray(file, header, 3) || header[0] != magic || header[1] != version || header[2] != hiddenSize)
+		{
+			return nullptr;
+		}
+
+		auto network = std::make_unique<Network>();
+
+		bool complete = readArray(file, network->featureWeights.data(), network->featureWeights.size())
+			&& readArray(file, network->featureBiases.data(), network->featureBiases.size())
+			&& readArray(file, network->outputWeights.data(), network->outputWeights.size())
+			&& readArray(file, &network->outputBias, 1);
+
+		return complete ? std::move(network) : nullptr;
+	}
+
+	bool Network::save(const std::string& fileName) const
+	{
+		std::ofstream file(fileName, std::ios::binary);
+		const uint32_t header[3] = { magic, version, hiddenSize };
+
+		return file && writeArray(file, header, 3)
+			&& writeArray(file, featureWeights.data(), featureWeights.size())
+			&& writeArray(file, featureBiases.data(), featureBiases.size())
+			&& writeArray(file, outputWeights.data(), outputWeights.size())
+			&& writeArray(file, &outputBias, 1);
+	}
+
+	std::unique_ptr<Network> Network::random(uint64_t seed)
+	{
+		std::mt19937_64 random(seed);
+		std::uniform_int_distribution<int> feature(-64, 64);
+		std::uniform_int_distribution<int> output(-128, 128);
+
+		auto network = std::make_unique<Network>();
+
+		std::generate(network->featureWeights.begin(), network->featureWeights.end(), [&]() { return static_cast<int16_t>(feature(random)); });
+		std::generate(network->featureBiases.begin(), network->featureBiases.end(), [&]() { return static_cast<int16_t>(feature(random)); });
+		std::generate(network->outputWeights.begin(), network->outputWeights.end(), [&]() { return static_cast<int16_t>(output(random)); });
+		network->outputBias = output(random);
+
+		return network;
+	}
+
+	const Network* defaultNetwork()
+	{
+#ifdef CHESS_ENGINE_NNUE
+		static const std::unique_ptr<Network> network = Network::load(NNUE_PATH);
+		return network.get();
+#else
+		return nullptr;
+#endif
+	}
+
+	Evaluator::Evaluator(const Network& network) :
+		network{ network },
+		accumulators(Consts::stackSize + 1)
+	{
+	}
+
+	int Evaluator::evaluate(const ChessBoard& board)
+	{
+		int ply = board.getPly();
+
+		// closest ancestor whose accumulator still belongs to the position on the board's stack
+		int base = ply;
+		while (base >= 0 && ply - base <= maxUpdatePlies &&
+			!(accumulators[base].computed && accumulators[base].zobristKey == board.getZobristKeyAt(base)))
+		{
+			base--;
+		}
+
+		if (base < 0 || ply - base > maxUpdatePlies)
+		{
+			base = ply;
+			refresh(accumulators[ply], board.getBitboardsAt(ply));
+		}
+
+		for (int i = base + 1; i <= ply; i++)
+		{
+			update(accumulators[i], accumulators[i - 1], board.getBitboardsAt(i - 1), board.getBitboardsAt(i));
+		}
+
+		for (int i = base; i <= ply; i++)
+		{
+			accumulators[i].zobristKey = board.getZobristKeyAt(i);
+			accumulators[i].computed = true;
+		}
+
+		const Accumulator& accumulator = accumulators[ply];
+		int perspective = board.isWhiteToMove() ? 1 : 0;
+
+		int32_t output = outputLayer(accumulator.values[perspective].data(), accumulator.values[perspective ^ 1].data(), network.outputWeights.data());
+		output += network.outputBias;
+
+		return static_cast<int>(static_cast<int64_t>(output) * outputScale / (QA * QB));
+	}
+
+	void Evaluator::refresh(Accumulator& accumulator, const std::array<uint64_t, Consts::TotalBitboards>& bitboards) const
+	{
+		for (int perspective = 0; perspective < 2; perspective++)
+		{
+			accumulator.values[perspective] = network.featureBiases;
+
+			for (int piece = Piece::WhiteRook; piece <= Piece::BlackPawn; piece++)
+			{
+				uint64_t pieces = bitboards[piece];
+
+				while (pieces)
+				{
+					addWeights(accumulator.values[perspective].data(), &network.featureWeights[featureIndex(perspective, piece, std::countr_zero(pieces))]);
+					pieces &= (pieces - 1);
+				}
+			}
+		}
+	}
+
+	void Evaluator::update(Accumulator& accumulator, const Accumulator& previous,
+		const std::array<uint64_t, Consts::TotalBitboards>& previousBitboards,
+		const std::array<uint64_t, Consts::TotalBitboards>& bitboards) const
+	{
+		accumulator.values = previous.values;
+
+		for (int piece = Piece::WhiteRook; piece <= Piece::BlackPawn; piece++)
+		{
+			uint64_t removed = previousBitboards[piece] & ~bitboards[piece];
+			uint64_t added = bitboards[piece] & ~previousBitboards[piece];
+
+			for (int perspective = 0; perspective < 2; perspective++)
+			{
+				int16_t* values = accumulator.values[perspective].data();
+
+				for (uint64_t pieces = removed; pieces; pieces &= (pieces - 1))
+				{
+					subtractWeights(values, &network.featureWeights[featureIndex(perspective, piece, std::countr_zero(pieces))]);
+				}
+
+				for (uint64_t pieces = added; pieces; pieces &= (pieces - 1))
+				{
+					addWeights(values, &network.featureWeights[featureIndex(perspective, piece, std::countr_zero(pieces))]);
+				}
+			}
+		}
+	}
+
+#if defined(__AVX2__)
+
+	void addWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i += 16)
+		{
+			__m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+			values = _mm256_add_epi16(values, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), values);
+		}
+	}
+
+	void subtractWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i += 16)
+		{
+			__m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+			values = _mm256_sub_epi16(values, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), values);
+		}
+	}
+
+	int32_t outputLayer(const int16_t* us, const int16_t* them, const int16_t* weights)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i qa = _mm256_set1_epi16(QA);
+		__m256i sum = _mm256_setzero_si256();
+
+		for (int half = 0; half < 2; half++)
+		{
+			const int16_t* values = half == 0 ? us : them;
+			const int16_t* halfWeights = weights + half * hiddenSize;
+
+			for (int i = 0; i < hiddenSize; i += 16)
+			{
+				__m256i clipped = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), zero), qa);
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(clipped, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(halfWeights + i))));
+			}
+		}
+
+		__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return _mm_cvtsi128_si32(sum128);
+	}
+
+#elif defined(NNUE_SSE2)
+
+	void addWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i += 8)
+		{
+			__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+			values = _mm_add_epi16(values, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), values);
+		}
+	}
+
+	void subtractWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i += 8)
+		{
+			__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+			values = _mm_sub_epi16(values, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), values);
+		}
+	}
+
+	int32_t outputLayer(const int16_t* us, const int16_t* them, const int16_t* weights)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i qa = _mm_set1_epi16(QA);
+		__m128i sum = _mm_setzero_si128();
+
+		for (int half = 0; half < 2; half++)
+		{
+			const int16_t* values = half == 0 ? us : them;
+			const int16_t* halfWeights = weights + half * hiddenSize;
+
+			for (int i = 0; i < hiddenSize; i += 8)
+			{
+				__m128i clipped = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), zero), qa);
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(clipped, _mm_loadu_si128(reinterpret_cast<const __m128i*>(halfWeights + i))));
+			}
+		}
+
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return _mm_cvtsi128_si32(sum);
+	}
+
+#else
+
+	void addWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i++)
+		{
+			accumulator[i] += weights[i];
+		}
+	}
+
+	void subtractWeights(int16_t* accumulator, const int16_t* weights)
+	{
+		for (int i = 0; i < hiddenSize; i++)
+		{
+			accumulator[i] -= weights[i];
+		}
+	}
+
+	int32_t outputLayer(const int16_t* us, const int16_t* them, const int16_t* weights)
+	{
+		return outputLayerScalar(us, them, weights);
+	}
+
+#endif
+
+	int32_t outputLayerScalar(const int16_t* us, const int16_t* them, const int16_t* weights)
+	{
+		int32_t sum = 0;
+
+		for (int i = 0; i < hiddenSize; i++)
+		{
+			sum += std::clamp<int32_t>(us[i], 0, QA) * weights[i];
+			sum += std::clamp<int32_t>(them[i], 0, QA) * weights[hiddenSize + i];
+		}
+
+		return sum;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ChessBoard.h"
+
+#ifndef NNUE_PATH
+#define NNUE_PATH "./network.nnue"
+#endif
+
+namespace Chess::Nnue
+{
+	// (color, piece, square) features of one perspective, accumulated into hiddenSize neurons per perspective
+	static constexpr int inputSize = 768;
+	static constexpr int hiddenSize = 128;
+
+	// Quantization, accumulator values are clipped to [0, QA], output weights are scaled by QB
+	static constexpr int QA = 255;
+	static constexpr int QB = 64;
+	static constexpr int outputScale = 400;
+
+	// 768 -> 2x128 -> 1, the side to move's half of the hidden layer comes first.
+	// File: magic, version, hidden size (uint32), then every array below in order, little endian
+	struct Network
+	{
+		static constexpr uint32_t magic = 0x45554E4E;	// "NNUE"
+		static constexpr uint32_t version = 1;
+
+		alignas(64) std::array<int16_t, inputSize * hiddenSize> featureWeights;
+		alignas(64) std::array<int16_t, hiddenSize> featureBiases;
+		alignas(64) std::array<int16_t, 2 * hiddenSize> outputWeights;
+		int32_t outputBias;
+
+		// nullptr if the file cannot be read or has a different architecture
+		static std::unique_ptr<Network> load(const std::string& fileName);
+		bool save(const std::string& fileName) const;
+
+		// Small random weights, only useful for testing
+		static std::unique_ptr<Network> random(uint64_t seed);
+	};
+
+	// Network loaded from NNUE_PATH when the engine is built with CHESS_ENGINE_NNUE, otherwise nullptr
+	const Network* defaultNetwork();
+
+	// Hidden layer of both perspectives ([0] black, [1] white) for one position
+	struct Accumulator
+	{
+		alignas(64) std::array<std::array<int16_t, hiddenSize>, 2> values;
+		uint64_t zobristKey = 0;
+		bool computed = false;
+	};
+
+	// Evaluates with one network, keeps an accumulator for every ply of the board's make/unmake stack.
+	// Accumulators are updated lazily from the closest computed ancestor, so only evaluated positions
+	// cost anything. One per search thread (not thread-safe)
+	class Evaluator
+	{
+		// Further ancestors are not worth it, a refresh adds every piece once
+		static constexpr int maxUpdatePlies = 8;
+
+		const Network& network;
+		std::vector<Accumulator> accumulators;
+
+	public:
+		explicit Evaluator(const Network& network);
+
+		// Score from the side to move's perspective
+		int evaluate(const ChessBoard& board);
+
+	private:
+		void refresh(Accumulator& accumulator, const std::array<uint64_t, Consts::TotalBitboards>& bitboards) const;
+		void update(Accumulator& accumulator, const Accumulator& previous,
+			const std::array<uint64_t, Consts::TotalBitboards>& previousBitboards,
+			const std::array<uint64_t, Consts::TotalBitboards>& bitboards) const;
+	};
+
+	// Kernels, the SIMD versions are chosen at compile time (AVX2, SSE2 or scalar)
+	void addWeights(int16_t* accumulator, const int16_t* weights);
+	void subtractWeights(int16_t* accumulator, const int16_t* weights);
+	int32_t outputLayer(const int16_t* us, const int16_t* them, const int16_t* weights);
+	int32_t outputLayerScalar(const int16_t* us, const int16_t* them, const int16_t* weights);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Debug.h"
+#include "Evaluation.h"
+
+namespace Chess
+{
+	// Pawn structure of one position, everything here depends only on the pawns.
+	// Bitboards are indexed like the passed pawn tables ([0] black, [1] white)
+	struct PawnEntry
+	{
+		// the pawns are stored to verify the entry, so a collision never returns another structure.
+		// A blank entry has pawns on every square, so it never matches a position (not even one without pawns)
+		uint64_t whitePawns = ~0ULL;
+		uint64_t blackPawns = ~0ULL;
+
+		Evaluation::Score score = 0;	// doubled, isolated, connected and passed pawns, white minus black
+
+		std::array<uint64_t, 2> passedPawns{};
+		std::array<uint64_t, 2> pawnAttacks{};
+		std::array<uint64_t, 2> outposts{};		// no enemy pawn ahead on the same or an adjacent file
+	};
+
+	// Fixed size table indexed by the pawn zobrist key, one per search thread (not thread-safe)
+	class PawnHashTable
+	{
+		static constexpr size_t tableSize = 1 << 14;	// power of 2
+
+		std::vector<PawnEntry> entries = std::vector<PawnEntry>(tableSize);
+
+	public:
+		// written by the owning thread, readable from any thread
+		RelaxedCounter probes;
+		RelaxedCounter hits;
+
+		// Entry of the given pawns, evaluated and stored on a miss
+		const PawnEntry& probe(uint64_t pawnKey, uint64_t whitePawns, uint64_t blackPawns)
+		{
+			PawnEntry& entry = entries[pawnKey & (tableSize - 1)];
+			probes++;
+
+			if (entry.whitePawns == whitePawns && entry.blackPawns == blackPawns)
+			{
+				hits++;
+				return entry;
+			}
+
+			entry = Evaluation::evaluatePawns(whitePawns, blackPawns);
+			return entry;
+		}
+
+		void resetStats()
+		{
+			probes.reset();
+			hits.reset();
+		}
+	};
+}
@@ -3,15 +3,35 @@
 #include "Sort.h"
 #include "Search.h"
 #include <utility>
+#include <cassert>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 namespace Chess
 {
-	void Search::orderMoves(std::array<Move, Consts::MaxPossibleMoves>& moves, int moveSize)
+	std::array<std::array<int, Consts::MaxPossibleMoves>, Search::maxSearchDepth + 1> Search::reductions { };
+
+	void Search::initReductions()
+	{
+		// log(depth) * log(moveNumber) reductions, index 0 is never reduced
+		for (int depth = 1; depth <= maxSearchDepth; depth++)
+		{
+			for (int moveNumber = 1; moveNumber < Consts::MaxPossibleMoves; moveNumber++)
+			{
+				reductions[depth][moveNumber] = static_cast<int>(0.75 + std::log(depth) * std::log(moveNumber) / 2.25);
+			}
+		}
+	}
+
+	void Search::orderMoves(std::array<Move, Consts::MaxPossibleMoves>& moves, int moveSize, int ply, Move previousMove)
 	{
 		std::array<int, Consts::MaxPossibleMoves> moveScores = {};
 		bool whiteToMove = board.isWhiteToMove();
 
+		const std::array<Move, 2> killers = ply < maxPly ? killerMoves[ply] : std::array<Move, 2>{};
+		const Move counterMove = previousMove.isNullMove() ? Move{} : counterMoves[previousMove.from][previousMove.to];
+		const PieceToHistory* contHistory = getContinuationHistory(previousMove);
 
 		for (int i = 0; i < moveSize; i++)
 		{
@@ -42,7 +62,27 @@ namespace Chess
 				score += (10 * victimValue) - attackerValue;
 			}
 
-			score += moveHistory[(int)whiteToMove][move.from][move.to];
+			if (toPiece != Piece::None || move.isPromotion() || move.isEnPassant())
+			{
+				score += captureOrderBonus;
+			}
+			else if (move == killers[0] || move == killers[1])
+			{
+				score += killerOrderBonus;
+			}
+			else if (move == counterMove)
+			{
+				score += counterMoveOrderBonus;
+			}
+			else
+			{
+				score += moveHistory[(int)whiteToMove][move.from][move.to];
+
+				if (contHistory)
+				{
+					score += (*contHistory)[board.getPiece(1ULL << move.from)][move.to];
+				}
+			}
 
 			moveScores[i] = score;
 		}
@@ -50,12 +90,268 @@ namespace Chess
 		Sort::Quicksort(moves, moveScores, 0, moveSize - 1);
 	}
 
-	Move Search::searchBestMove(ChessBoard& chessBoard)
+	Search::PieceToHistory* Search::getContinuationHistory(Move previousMove)
+	{
+		if (previousMove.isNullMove())
+		{
+			return nullptr;
+		}
+
+		Piece previousPiece = board.getPiece(1ULL << previousMove.to);
+		return &(*continuationHistory)[previousPiece * 64 + previousMove.to];
+	}
+
+	void Search::updateQuietHistories(Move bestMove, const std::array<Move, Consts::MaxPossibleMoves>& quietsTried,
+		int quietsCount, int depth, int ply, Move previousMove)
+	{
+		bool whiteToMove = board.isWhiteToMove();
+		int bonus = std::min(16 * depth * depth, maxHistoryBonus);
+		PieceToHistory* contHistory = getContinuationHistory(previousMove);
+
+		if (ply < maxPly && killerMoves[ply][0] != bestMove)
+		{
+			killerMoves[ply][1] = killerMoves[ply][0];
+			killerMoves[ply][0] = bestMove;
+		}
+
+		if (!previousMove.isNullMove())
+		{
+			counterMoves[previousMove.from][previousMove.to] = bestMove;
+		}
+
+		// reward the cutoff move and penalize quiet moves searched before it
+		for (int i = 0; i < quietsCount; i++)
+		{
+			const Move& move = quietsTried[i];
+			int moveBonus = move == bestMove ? bonus : -bonus;
+
+			applyHistoryBonus(moveHistory[whiteToMove][move.from][move.to], moveBonus);
+
+			if (contHistory)
+			{
+				applyHistoryBonus((*contHistory)[board.getPiece(1ULL << move.from)][move.to], moveBonus);
+			}
+		}
+	}
+
+	void Search::setTimeLimits(std::chrono::milliseconds timeLeft, std::chrono::milliseconds increment, int movesToGo)
+	{
+		timeManager.start(timeLeft, increment, movesToGo);
+	}
+
+	void Search::setMoveTime(std::chrono::milliseconds moveTime)
+	{
+		timeManager.startFixed(moveTime);
+	}
+
+	void Search::checkLimits()
+	{
+		uint64_t nodes = stats.nodesVisited.load();
+
+		// exact, so node limited searches stop at the same node every time
+		if (nodeLimit != 0 && nodes >= nodeLimit)
+		{
+			stopSearch();
+		}
+
+		if ((nodes & (timeCheckInterval - 1)) == 0 && !pondering.load(std::memory_order_acquire)
+			&& timeManager.isHardLimitReached())
+		{
+			stopSearch();
+		}
+	}
+
+	void Search::ponderHit()
+	{
+		timeManager.restartClock();
+
+		pondering.store(false, std::memory_order_release);
+		pondering.notify_all();
+	}
+
+	void Search::stopSearch()
+	{
+		abortSearch.store(true, std::memory_order_relaxed);
+
+		pondering.store(false, std::memory_order_release);
+		pondering.notify_all();
+	}
+
+	std::chrono::milliseconds Search::getElapsed() const
+	{
+		auto end = searching.load() ? std::chrono::steady_clock::now() : searchEnd.load();
+		return std::chrono::duration_cast<std::chrono::milliseconds>(end - searchStart.load());
+	}
+
+	SearchStats Search::getSearchStats() const
+	{
+		uint64_t nodesVisited = stats.nodesVisited.load();
+		uint64_t elapsed = std::max<int64_t>(getElapsed().count(), 1);
+
+		return SearchStats{
+			stats.depth.load(std::memory_order_relaxed),
+			nodesVisited,
+			stats.nodesEvaluated.load(),
+			stats.nodesPruned.load(),
+			stats.nodesTransposed.load(),
+			nodesVisited * 1000 / elapsed,
+			pawnHash.probes.load(),
+			pawnHash.hits.load(),
+			stats.lazyEvaluations.load()
+		};
+	}
+
+	SearchInfo Search::getSearchInfo() const
+	{
+		SearchInfo info;
+
+		// retry until no iteration was published while reading
+		uint32_t sequenceBefore;
+		uint32_t sequenceAfter;
+
+		do
+		{
+			sequenceBefore = infoSequence.load(std::memory_order_acquire);
+
+			info.whiteToMove = infoWhiteToMove.load(std::memory_order_relaxed);
+			info.hashFull = infoHashFull.load(std::memory_order_relaxed);
+
+			int lines = std::clamp(infoLineCount.load(std::memory_order_relaxed), 0, maxMultiPV);
+			info.lines.resize(lines);
+
+			for (int line = 0; line < lines; line++)
+			{
+				SearchLine& searchLine = info.lines[line];
+				searchLine.evaluation = infoEvaluation[line].load(std::memory_order_relaxed);
+				int length = std::clamp(infoPVLength[line].load(std::memory_order_relaxed), 0, maxPly);
+
+				searchLine.moves.clear();
+				for (int i = 0; i < length; i++)
+				{
+					searchLine.moves.push_back(Move::decode(infoPV[line][i].load(std::memory_order_relaxed)));
+				}
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			sequenceAfter = infoSequence.load(std::memory_order_relaxed);
+		}
+		while ((sequenceBefore & 1) || sequenceBefore != sequenceAfter);
+
+		info.stats = getSearchStats();
+		info.elapsed = getElapsed();
+
+		return info;
+	}
+
+	int Search::extractPrincipalVariation(Move firstMove, std::array<Move, maxPly>& principalVariation)
+	{
+		principalVariation[0] = firstMove;
+		board.makeMove(firstMove);
+
+		int length = 1;
+
+		// follow the PVTable, every move is checked for legality in case of key collisions
+		while (length < currentDepth)
+		{
+			auto it = PVTable.find(board.getZobristKey());
+
+			if (it == PVTable.end())
+			{
+				break;
+			}
+
+			board.generateMoves();
+			const auto& legalMoves = board.getLegalMoves();
+			auto legalEnd = legalMoves.begin() + board.getMovesSize();
+
+			if (std::find(legalMoves.begin(), legalEnd, it->second) == legalEnd)
+			{
+				break;
+			}
+
+			principalVariation[length++] = it->second;
+			board.makeMove(it->second);
+		}
+
+		for (int i = 0; i < length; i++)
+		{
+			board.unmakeMove();
+		}
+
+		return length;
+	}
+
+	void Search::publishSearchInfo()
+	{
+		int lines = searchedLines;
+
+		std::array<std::array<Move, maxPly>, maxMultiPV> principalVariations;
+		std::array<int, maxMultiPV> lengths = {};
+
+		for (int line = 0; line < lines; line++)
+		{
+			lengths[line] = extractPrincipalVariation(orderedMoves[line], principalVariations[line]);
+		}
+
+		uint32_t sequence = infoSequence.load(std::memory_order_relaxed);
+		infoSequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		infoWhiteToMove.store(board.isWhiteToMove(), std::memory_order_relaxed);
+		infoHashFull.store(static_cast<int>(std::min<size_t>(transpositionTable.size() * 1000 / transpositionTableCapacity, 1000)),
+			std::memory_order_relaxed);
+		infoLineCount.store(lines, std::memory_order_relaxed);
+
+		for (int line = 0; line < lines; line++)
+		{
+			infoEvaluation[line].store(moveScores[line], std::memory_order_relaxed);
+			infoPVLength[line].store(lengths[line], std::memory_order_relaxed);
+
+			for (int i = 0; i < lengths[line]; i++)
+			{
+				infoPV[line][i].store(principalVariations[line][i].encode(), std::memory_order_relaxed);
+			}
+		}
+
+		infoSequence.store(sequence + 2, std::memory_order_release);
+
+		if (infoCallback)
+		{
+			infoCallback(getSearchInfo());
+		}
+	}
+
+	Move Search::searchBestMove(ChessBoard& chessBoard, std::stop_token stopToken)
 	{ 
 		board = chessBoard;
 
-		moveHistory = {};
-		stats = { 0, 0, 0, 0, 0 };
+		abortSearch = false;
+		std::stop_callback stopCallback(stopToken, [this] { stopSearch(); });
+
+		searchStart = std::chrono::steady_clock::now();
+		searching = true;
+
+		// age history from the previous search, killers are only valid for the current one
+		for (auto& fromTable : moveHistory)
+		{
+			for (auto& toTable : fromTable)
+			{
+				for (int& entry : toTable)
+				{
+					entry /= 2;
+				}
+			}
+		}
+
+		killerMoves = {};
+
+		stats.depth.store(0, std::memory_order_relaxed);
+		stats.nodesVisited.reset();
+		stats.nodesEvaluated.reset();
+		stats.nodesPruned.reset();
+		stats.nodesTransposed.reset();
+		stats.lazyEvaluations.reset();
+		pawnHash.resetStats();
 
 		// almost the same performance with and without clear;
 		//PVTable.clear();
@@ -69,38 +365,63 @@ namespace Chess
 		movesSize = board.getMovesSize();
 		moveScores = {};
 
-		for (currentDepth = 1; currentDepth <= maxSearchDepth; currentDepth++)
+		// the order of the moves can change in an interrupted iteration, keep the last complete result
+		// (null move if the game is already over)
+		Move bestMove = movesSize > 0 ? orderedMoves[0] : Move{ 0, 0 };
+
+		int maxDepth = depthLimit > 0 ? std::min(depthLimit, maxSearchDepth) : maxSearchDepth;
+
+		for (currentDepth = 1; currentDepth <= maxDepth && movesSize > 0; currentDepth++)
 		{
-			if (abortSearch)
+			if (abortSearch || (currentDepth > 1 && !pondering && !timeManager.shouldStartIteration()))
 			{
 				break;
 			}
 
 			search(currentDepth);
 
-			if (evaluation >= 10000000 || evaluation <= -10000000)
+			if (abortSearch)
 			{
 				break;
-				std::cout << "Found Mate";
 			}
 
-			stats.depth = currentDepth;
+			bestMove = orderedMoves[0];
+
+			stats.depth.store(currentDepth, std::memory_order_relaxed);
+			timeManager.updateIteration(bestMove, evaluation, std::abs(evaluation) >= mateScoreThreshold);
+			publishSearchInfo();
+
+			// every mate up to the current depth was searched, so a shorter one cannot be found
+			if (std::abs(evaluation) >= mateScoreThreshold && mateScore - std::abs(evaluation) <= currentDepth)
+			{
+				break;
+			}
+
+			// nothing to think about with a single legal move
+			if (movesSize == 1 && !pondering && timeManager.isLimited())
+			{
+				break;
+			}
 		}
 
-		// reset abort search for the next search;
-		abortSearch = false;
+		// the search may finish early (mate or max depth), but a ponder search waits for the ponder hit or stop
+		pondering.wait(true);
 
-		return orderedMoves[0];
+		// reset limits for the next search;
+		timeManager.startInfinite();
+		depthLimit = 0;
+		nodeLimit = 0;
+
+		searchEnd = std::chrono::steady_clock::now();
+		searching = false;
+
+		return bestMove;
 	}
 
 	void Search::search(int depth)
 	{
-		int alpha = Evaluation::NegInfinity;	// == -beta == -Inf
 		int beta = Evaluation::PosInfinity;		// == -alpha == +Inf
 
-		int bestScore = Evaluation::NegInfinity;
-		//std::array<Move, Consts::MaxPossibleMoves> moves = orderedMoves;
-
 		uint64_t zobristKey = board.getZobristKey();
 
 		if (PVTable.contains(zobristKey))
@@ -114,37 +435,62 @@ namespace Chess
 			}
 		}
 
-		for (int i = 0; i < movesSize; i++)
+		// every pass finds the best move among the ones not yet chosen by the previous passes,
+		// the transposition and PV tables are shared between them
+		int lines = std::min(multiPV.load(std::memory_order_relaxed), static_cast<int>(movesSize));
+		searchedLines = lines;
+
+		for (int pvIndex = 0; pvIndex < lines; pvIndex++)
 		{
-			if (abortSearch)
+			int alpha = Evaluation::NegInfinity;	// == -beta == -Inf
+			size_t bestIndex = pvIndex;
+
+			for (size_t i = pvIndex; i < movesSize; i++)
 			{
-				return;
-			}
+				if (abortSearch)
+				{
+					return;
+				}
 
-			board.makeMove(orderedMoves[i]);
+				board.makeMove(orderedMoves[i]);
 
-			int moveScore = -alphaBetaPruning(depth - 1, -beta, -alpha);
+				int moveScore = -alphaBetaPruning(depth - 1, 1, -beta, -alpha);
 
-			board.unmakeMove();
+				board.unmakeMove();
 
-			moveScores[i] = moveScore;
-			
-			if (moveScore > alpha)
-			{
-				alpha = moveScore;
-				PVTable[zobristKey] = orderedMoves[i];
+				// scores of an interrupted search are not reliable
+				if (abortSearch)
+				{
+					return;
+				}
+
+				moveScores[i] = moveScore;
+
+				if (moveScore > alpha)
+				{
+					alpha = moveScore;
+					bestIndex = i;
+				}
 			}
+
+			// fail-low moves can return the same score as the best move, so the best move is moved
+			// to its place directly instead of relying on the sort
+			std::rotate(orderedMoves.begin() + pvIndex, orderedMoves.begin() + bestIndex, orderedMoves.begin() + bestIndex + 1);
+			std::rotate(moveScores.begin() + pvIndex, moveScores.begin() + bestIndex, moveScores.begin() + bestIndex + 1);
 		}
 
-		evaluation = alpha;
+		// a later pass can still find a higher score than an earlier one
+		Sort::Quicksort(orderedMoves, moveScores, 0, lines - 1);
+		Sort::Quicksort(orderedMoves, moveScores, lines, movesSize - 1);
 
-		Sort::Quicksort(orderedMoves, moveScores, 0, movesSize - 1);
+		evaluation = moveScores[0];
+		PVTable[zobristKey] = orderedMoves[0];
 	}
 
 	// alpha - maximum current player can get
 	// beta - least opposite player can gain
 	// NullCheck - flag to avoid doing NullMoves inside each other
-	int Search::alphaBetaPruning(int depth, int alpha, int beta)
+	int Search::alphaBetaPruning(int depth, int ply, int alpha, int beta)
 	{
 		if (abortSearch)
 		{
@@ -152,6 +498,18 @@ namespace Chess
 		}
 
 		stats.nodesVisited++;
+		checkLimits();
+
+		assert(ply < maxPly);
+
+		// Mate distance pruning, a mate found closer to the root already scores better than anything here
+		alpha = std::max(alpha, -mateScore + ply);
+		beta = std::min(beta, mateScore - ply - 1);
+
+		if (alpha >= beta)
+		{
+			return alpha;
+		}
 
 		if (depth == 0)
 		{
@@ -163,14 +521,19 @@ namespace Chess
 			if (inTranspositionTable)
 			{
 				stats.nodesTransposed++;
-				eval = transpositionTable[zobristKey];
+				eval = scoreFromTT(transpositionTable[zobristKey], ply);
 			}
 			else
 			{
 				stats.nodesEvaluated++;
-				eval = QuiescenceSearch(alpha, beta);
+				eval = QuiescenceSearch(0, ply, alpha, beta);
 				//eval = Evaluation::EvaluatePosition(board);
-				transpositionTable[zobristKey] = eval;
+
+				// bounds depend on the window, only exact scores can be reused
+				if (eval > alpha && eval < beta && !abortSearch && transpositionTable.size() < transpositionTableCapacity)
+				{
+					transpositionTable[zobristKey] = scoreToTT(eval, ply);
+				}
 			}
 				 
 			return eval;
@@ -188,18 +551,63 @@ namespace Chess
 			stats.nodesEvaluated++;
 			int gameOverEval = Evaluation::EvaluatePosition(board);
 
-			// prioritize faster checkmates
-			gameOverEval = gameOverEval > 0 ? gameOverEval + depth : gameOverEval - depth;
-			return gameOverEval;
+			// faster checkmates score higher
+			if (gameOverEval != 0)
+			{
+				return gameOverEval > 0 ? mateScore - ply : -mateScore + ply;
+			}
+
+			return 0;
+		}
+
+		bool whiteToMove = board.isWhiteToMove();
+		bool inCheck = board.isKingInCheck(whiteToMove, board.getMasks().threatMap);
+
+		// Check extension, search positions after a check one ply deeper. Only up to twice the iteration
+		// depth, long checking sequences would run into maxPly otherwise
+		int extension = inCheck && params.checkExtensions && ply < 2 * currentDepth ? 1 : 0;
+		depth += extension;
+
+		// Null window nodes are not expected to change the principal variation
+		bool pvNode = beta > alpha + 1;
+		int staticEval = inCheck ? Evaluation::NegInfinity : evaluate();
+
+		uint64_t zobristKey = board.getZobristKey();
+		bool hasBestMove = PVTable.contains(zobristKey);
+
+		// Internal iterative reductions, a node never searched before is unlikely to be important
+		if (params.internalIterativeReductions && !pvNode && !hasBestMove && depth >= params.iirMinDepth)
+		{
+			depth--;
+		}
+
+		// Reverse futility pruning, static evaluation beats beta by a large margin
+		if (params.reverseFutilityPruning && !pvNode && !inCheck && depth <= params.reverseFutilityMaxDepth &&
+			std::abs(beta) < mateScoreThreshold && staticEval - params.reverseFutilityMargin * depth >= beta)
+		{
+			stats.nodesPruned++;
+			return beta;
+		}
+
+		// Razoring, static evaluation is so low that only captures could help
+		if (params.razoring && !pvNode && !inCheck && depth <= params.razoringMaxDepth &&
+			std::abs(alpha) < mateScoreThreshold && staticEval + params.razoringMargin * depth < alpha)
+		{
+			int razorScore = QuiescenceSearch(0, ply, alpha - 1, alpha);
+
+			if (razorScore < alpha)
+			{
+				stats.nodesPruned++;
+				return razorScore;
+			}
 		}
 
 		// Null move pruning
-		if (depth >= 5 && !board.isKingInCheck(board.getMasks().threatMap))
+		if (params.nullMovePruning && depth >= params.nullMoveMinDepth && !inCheck && std::abs(beta) < mateScoreThreshold)
 		{
 			// additionally reduce depth for faster calculations in endgame positions
-			const int reducedDepth = 2;
 			board.makeMove(Move {0, 0});
-			int nullMoveScore = -alphaBetaPruning(depth - 1 - reducedDepth, -beta, -beta + 1);
+			int nullMoveScore = -alphaBetaPruning(depth - 1 - params.nullMoveReduction, ply + 1, -beta, -beta + 1);
 			board.unmakeMove();
 
 			// If null move score is >= beta, prune this branch
@@ -210,11 +618,29 @@ namespace Chess
 			}
 		}
 
+		// Internal iterative deepening, a shallow search of the same node finds a move to try first.
+		// The node extends itself again, so the shallow search starts from the unextended depth
+		if (params.internalIterativeDeepening && pvNode && !hasBestMove && depth >= params.iidMinDepth)
+		{
+			alphaBetaPruning(depth - extension - params.iidReduction, ply, alpha, beta);
+
+			if (abortSearch)
+			{
+				return 0;
+			}
+		}
+
 		// order moves
-		orderMoves(legalMoves, movesSize);
+		Move previousMove = board.getGameState().getLastMove();
+		orderMoves(legalMoves, movesSize, ply, previousMove);
+
+		const Move counterMove = previousMove.isNullMove() ? Move{} : counterMoves[previousMove.from][previousMove.to];
+		const PieceToHistory* contHistory = getContinuationHistory(previousMove);
+
+		std::array<Move, Consts::MaxPossibleMoves> quietsTried;
+		int quietsCount = 0;
 		
 		// try to find the best move from PVTable
-		uint64_t zobristKey = board.getZobristKey();
 		if (PVTable.contains(zobristKey))
 		{
 			Move bestMove = PVTable[zobristKey];
@@ -232,21 +658,72 @@ namespace Chess
 			bool needsFullSearch = true;
 			Move move = legalMoves[i];
 
-			// assume that if move is bad at lower depth it is also bad at higher
-			/*if (depth >= 3 && !board.isKingInCheck(board.getMasks().threatMap))
+			bool isQuiet = board.getPieceType(move.to) == Piece::None && !move.isPromotion() && !move.isEnPassant();
+			bool isRefutation = move == killerMoves[ply][0] || move == killerMoves[ply][1] || move == counterMove;
+			int moveScore = 0;
+
+			int history = moveHistory[whiteToMove][move.from][move.to];
+			if (isQuiet && contHistory)
+			{
+				history += (*contHistory)[board.getPiece(1ULL << move.from)][move.to];
+			}
+
+			board.makeMove(move);
+
+			// captures and checks are never pruned or reduced
+			bool canPrune = isQuiet && !inCheck && i > 0 && !board.isKingInCheck(board.isWhiteToMove());
+
+			// Futility pruning, quiet move cannot raise static evaluation above alpha
+			if (params.futilityPruning && canPrune && !pvNode && depth <= params.futilityMaxDepth && alpha > -mateScoreThreshold &&
+				staticEval + params.futilityBaseMargin + params.futilityMargin * depth <= alpha)
 			{
-				const int reducedDepth = 2;
-				board.makeMove(Move{ 0, 0 });
-				int nullMoveScore = -alphaBetaPruning(depth - 1 - reducedDepth, -alpha - 1, -alpha);
 				board.unmakeMove();
+				stats.nodesPruned++;
+				continue;
+			}
 
-				needsFullSearch = nullMoveScore >= beta;
-			}*/
+			// late quiet moves are unlikely to be best, killers are never reduced
+			bool isLateMove = canPrune && !isRefutation && i >= params.lateMoveIndex;
+
+			// Late move pruning, skip remaining quiet moves at shallow depths
+			if (params.lateMovePruning && isLateMove && depth <= params.lmpMaxDepth &&
+				i >= params.lmpBaseMoves + depth * depth && alpha > -mateScoreThreshold)
+			{
+				board.unmakeMove();
+				stats.nodesPruned++;
+				continue;
+			}
+
+			// Late move reductions, search with reduced depth and null window first
+			if (params.lateMoveReductions && isLateMove && depth >= params.lmrMinDepth)
+			{
+				int reduction = reductions[std::min(depth, maxSearchDepth)][i];
+
+				// moves that caused cutoffs before are reduced less, moves that failed are reduced more
+				reduction -= history / historyReductionDivisor;
+				reduction = std::clamp(reduction, 0, depth - 2);
+
+				if (reduction > 0)
+				{
+					moveScore = -alphaBetaPruning(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+
+					// re-search only if reduced search fails high
+					needsFullSearch = moveScore > alpha;
+				}
+			}
+
+			if (needsFullSearch)
+			{
+				moveScore = -alphaBetaPruning(depth - 1, ply + 1, -beta, -alpha);
+			}
 
-			board.makeMove(move);
-			int moveScore = -alphaBetaPruning(depth - 1, -beta, -alpha);
 			board.unmakeMove();
 
+			if (isQuiet)
+			{
+				quietsTried[quietsCount++] = move;
+			}
+
 			if (moveScore > alpha)
 			{
 				alpha = moveScore;
@@ -257,36 +734,79 @@ namespace Chess
 			{
 				stats.nodesPruned++;
 
-				bool white = (int)board.isWhiteToMove();
-				int movePower = moveHistory[white][move.from][move.to];
-				moveHistory[(int)white][move.from][move.to] = std::max(movePower, depth * depth);
+				if (isQuiet)
+				{
+					updateQuietHistories(move, quietsTried, quietsCount, depth, ply, previousMove);
+				}
 
-				return Evaluation::PosInfinity;
+				return beta;
 			}
 		}
 
 		return alpha;
 	}
 
-	int Search::QuiescenceSearch(int alpha, int beta)
+	// depth is 0 on the first quiescence ply and negative below it
+	int Search::QuiescenceSearch(int depth, int ply, int alpha, int beta)
 	{
+		if (abortSearch)
+		{
+			return 0;
+		}
+
 		stats.nodesVisited++;
 		stats.nodesEvaluated++;
+		checkLimits();
 
-		int staticEval = Evaluation::EvaluatePosition(board);
-		alpha = std::max(alpha, staticEval);
+		bool whiteToMove = board.isWhiteToMove();
+		bool inCheck = board.isKingInCheck(whiteToMove);
 
-		if (alpha >= beta)
+		if (ply >= maxPly)
 		{
-			stats.nodesPruned++;
-			return alpha;
+			return inCheck ? alpha : evaluate(alpha, beta);
+		}
+
+		// side in check cannot stand pat, all evasions are searched instead
+		int staticEval = Evaluation::NegInfinity;
+
+		if (!inCheck)
+		{
+			staticEval = evaluate(alpha, beta);
+			alpha = std::max(alpha, staticEval);
+
+			if (alpha >= beta)
+			{
+				stats.nodesPruned++;
+				return alpha;
+			}
+		}
+
+		bool generateChecks = !inCheck && depth == 0 && params.quiescenceChecks;
+
+		if (inCheck)
+		{
+			board.generateMoves();
+		}
+		else if (generateChecks)
+		{
+			board.generateCapturesAndChecks();
+		}
+		else
+		{
+			board.generateMoves(false);
 		}
 
-		board.generateMoves(false);
 		std::array<Move, Consts::MaxPossibleMoves> legalMoves = board.getLegalMoves();
 		size_t movesSize = board.getMovesSize();
 
-		orderMoves(legalMoves, movesSize);
+		// checkmate, there are no evasions
+		if (inCheck && movesSize == 0)
+		{
+			return -mateScore + ply;
+		}
+
+		// quiet moves are only searched as evasions or checks, so histories are looked up for them
+		orderMoves(legalMoves, movesSize, ply, (inCheck || generateChecks) ? board.getGameState().getLastMove() : Move{});
 
 		uint64_t zobristKey = board.getZobristKey();
 		if (PVTable.contains(zobristKey))
@@ -304,17 +824,28 @@ namespace Chess
 		{
 			const Move& move = legalMoves[i];
 
-			int captureValue = Evaluation::pieceValues[board.getPieceType(move.to)];
-			int margin = Evaluation::pieceValues[Piece::Pawn];
-
-			if (staticEval + captureValue + margin <= alpha)
+			if (!inCheck)
 			{
-				continue;
+				bool isPromotion = move.isPromotion();
+				bool isCapture = board.getPieceType(move.to) != Piece::None || move.isEnPassant();
+				int exchangeValue = staticExchangeEvaluation(move);
+
+				// SEE pruning, skip captures and checks that lose material
+				if (params.seePruning && !isPromotion && exchangeValue < 0)
+				{
+					continue;
+				}
+
+				// Delta pruning, even winning the exchange cannot raise alpha
+				if (params.deltaPruning && isCapture && !isPromotion && staticEval + exchangeValue + params.deltaMargin <= alpha)
+				{
+					continue;
+				}
 			}
 
 			board.makeMove(move);
 
-			int moveScore = -QuiescenceSearch(-beta, -alpha);
+			int moveScore = -QuiescenceSearch(depth - 1, ply + 1, -beta, -alpha);
 
 			board.unmakeMove();
 
@@ -334,13 +865,162 @@ namespace Chess
 		return alpha;
 	}
 
+	int Search::evaluate(int alpha, int beta)
+	{
+		// a repetition has the same key as the playable position, so game over scores are not cached
+		if (board.getGameState().isGameOver())
+		{
+			return Evaluation::EvaluatePosition(board);
+		}
+
+		uint64_t zobristKey = board.getZobristKey();
+		int score;
+
+		if (evalCache.probe(zobristKey, score))
+		{
+			return score;
+		}
+
+		if (nnue)
+		{
+			score = nnue->evaluate(board);
+		}
+		else if (params.lazyEvaluation)
+		{
+			// the bounds saturate, so an open window never stops early
+			int lazyLow = alpha > Evaluation::NegInfinity + params.lazyMargin ? alpha - params.lazyMargin : Evaluation::NegInfinity;
+			int lazyHigh = beta < Evaluation::PosInfinity - params.lazyMargin ? beta + params.lazyMargin : Evaluation::PosInfinity;
+			bool lazy = false;
+
+			score = Evaluation::EvaluatePosition(board, pawnHash, lazyLow, lazyHigh, lazy);
+
+			// only a bound, the full evaluation may be needed with another window
+			if (lazy)
+			{
+				stats.lazyEvaluations++;
+				return score;
+			}
+		}
+		else
+		{
+			score = Evaluation::EvaluatePosition(board, pawnHash);
+		}
+
+		evalCache.store(zobristKey, score);
+
+		return score;
+	}
+
+	int Search::staticExchangeEvaluation(const Move& move) const
+	{
+		// Least valuable attacker first
+		static constexpr int attackerOrder[6] = { Piece::Pawn, Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen, Piece::King };
+
+		std::array<uint64_t, Consts::TotalBitboards> bitboards = board.getBitboards();
+		std::array<int, 32> gain = {};
+
+		uint64_t occupiedSquares = board.getOccupiedSquares();
+		uint64_t fromMask = 1ULL << move.from;
+		bool white = board.isWhiteToMove();
+
+		int attacker = board.getPieceType(move.from);
+		int depth = 0;
+
+		gain[0] = move.isEnPassant() ? Evaluation::pieceValues[Piece::Pawn] : Evaluation::pieceValues[board.getPieceType(move.to)];
+
+		if (move.isEnPassant())
+		{
+			occupiedSquares &= ~(white ? (1ULL << move.to) << 8 : (1ULL << move.to) >> 8);
+		}
+
+		while (fromMask && depth < 31)
+		{
+			depth++;
+
+			// value if the current attacker is recaptured
+			gain[depth] = Evaluation::pieceValues[attacker] - gain[depth - 1];
+
+			if (std::max(-gain[depth - 1], gain[depth]) < 0)
+			{
+				break;
+			}
+
+			// remove the attacker, sliders behind it are found by recomputing attackers
+			occupiedSquares &= ~fromMask;
+			uint64_t attackers = board.getAttackersTo(move.to, occupiedSquares);
+
+			white = !white;
+			fromMask = 0ULL;
+
+			int colorMask = white ? Piece::White : Piece::Black;
+
+			for (int piece : attackerOrder)
+			{
+				uint64_t pieceAttackers = attackers & bitboards[piece | colorMask];
+
+				if (pieceAttackers)
+				{
+					fromMask = pieceAttackers & (~pieceAttackers + 1);
+					attacker = piece;
+					break;
+				}
+			}
+		}
+
+		while (--depth > 0)
+		{
+			gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+		}
+
+		return gain[0];
+	}
+
+	int Search::scoreToTT(int score, int ply)
+	{
+		if (score >= mateScoreThreshold)
+		{
+			return score + ply;
+		}
+
+		return score <= -mateScoreThreshold ? score - ply : score;
+	}
+
+	int Search::scoreFromTT(int score, int ply)
+	{
+		if (score >= mateScoreThreshold)
+		{
+			return score - ply;
+		}
+
+		return score <= -mateScoreThreshold ? score + ply : score;
+	}
+
+	void Search::setNetwork(const Nnue::Network* network)
+	{
+		nnue = network ? std::make_unique<Nnue::Evaluator>(*network) : nullptr;
+
+		// cached scores belong to the previous evaluation
+		evalCache.clear();
+	}
+
 	void Search::clearHistory()
 	{
 		//everything else is reseted on each search
 		transpositionTable.clear();
 		moveHistory = {};
+		killerMoves = {};
+		counterMoves = {};
+		continuationHistory->fill({});
 		PVTable = {};
 	}
+
+	void Search::setHashSize(int megabytes)
+	{
+		transpositionTableCapacity = std::max<size_t>(static_cast<size_t>(megabytes) * 1024 * 1024 / transpositionEntrySize, 1);
+
+		transpositionTable = {};
+		transpositionTable.reserve(transpositionTableCapacity);
+	}
 }
 
 
@@ -1,9 +1,22 @@
 #pragma once
 
 #include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+#include <vector>
+#include <functional>
 
 #include "ChessBoard.h"
 #include "Debug.h"
+#include "EvalCache.h"
+#include "Nnue.h"
+#include "PawnHash.h"
+#include "SearchParameters.h"
+#include "TimeManager.h"
 
 namespace Chess
 {
@@ -15,13 +28,120 @@ namespace Chess
 		}
 	};
 	
+	// Root move with its score and principal variation (first move included)
+	struct SearchLine
+	{
+		int evaluation;
+		std::vector<Move> moves;
+	};
+
+	// Consistent snapshot of the running (or last) search, lines are sorted from the best one
+	// and scored from the perspective of the side to move
+	struct SearchInfo
+	{
+		SearchStats stats;
+		std::chrono::milliseconds elapsed;
+		bool whiteToMove;
+		int hashFull;	// permille of the transposition table in use
+		std::vector<SearchLine> lines;
+	};
+
+	// Called by the search thread after every completed depth
+	using SearchInfoCallback = std::function<void(const SearchInfo&)>;
+
 	class Search
 	{
+	public:
+		static constexpr int maxMultiPV = 8;
+
+		// Being mated at ply n scores -(mateScore - n), so shorter mates score higher. Every score
+		// beyond the threshold is a mate, the gap is larger than the deepest ply
+		static constexpr int mateScore = 10'001'000;
+		static constexpr int mateScoreThreshold = mateScore - 1000;
+
+		// Estimated memory of one transposition table entry (key, score, node pointer, bucket and allocator overhead)
+		static constexpr size_t transpositionEntrySize = 40;
+		static constexpr size_t transpositionTableSize = 10'000'000;
+		static constexpr int defaultHashSize = static_cast<int>(transpositionTableSize * transpositionEntrySize / (1024 * 1024));
+
+	private:
 		static constexpr int maxSearchDepth = 30;
+		static constexpr int maxPly = 128;
+
+		// check extensions stop at ply 2 * depth, the remaining depth is never larger than the iteration depth
+		static_assert(3 * maxSearchDepth < maxPly);
+		static_assert(mateScore - mateScoreThreshold > maxPly);
+
+		// The clock is checked every timeCheckInterval nodes (power of 2)
+		static constexpr int timeCheckInterval = 2048;
+
+		// Move ordering scores, captures first, then killers and counter moves, then quiets by history
+		static constexpr int captureOrderBonus = 1'000'000;
+		static constexpr int killerOrderBonus = 900'000;
+		static constexpr int counterMoveOrderBonus = 800'000;
+
+		// History values are kept in [-maxHistory, maxHistory] by the gravity update
+		static constexpr int maxHistory = 16384;
+		static constexpr int maxHistoryBonus = 1536;
+		static constexpr int historyReductionDivisor = 8192;
+
+		// Precomputed reductions indexed by depth and move number
+		static std::array<std::array<int, Consts::MaxPossibleMoves>, maxSearchDepth + 1> reductions;
+
+		using PieceToHistory = std::array<std::array<int16_t, 64>, Consts::TotalBitboards>;
+
 		int currentDepth = 0;
-		bool abortSearch = false;
+		std::atomic<bool> abortSearch = false;
 
-		SearchStats stats;
+		// A ponder search ignores the time limits until ponderHit and does not return before it (or a stop),
+		// analysis is a ponder search that is never hit
+		std::atomic<bool> pondering = false;
+
+		// Number of best root moves searched with exact scores
+		std::atomic<int> multiPV = 1;
+		int searchedLines = 1;
+
+		SearchParameters params;
+		TimeManager timeManager;
+
+		// Deterministic limits for the next search, 0 means no limit
+		int depthLimit = 0;
+		uint64_t nodeLimit = 0;
+
+		// Node counters, readable from other threads while searching
+		struct SearchCounters
+		{
+			std::atomic<int> depth = 0;
+			RelaxedCounter nodesVisited;
+			RelaxedCounter nodesEvaluated;
+			RelaxedCounter nodesPruned;
+			RelaxedCounter nodesTransposed;
+			RelaxedCounter lazyEvaluations;
+		} stats;
+
+		// Pawn structure evaluations, kept between searches as they never become stale
+		PawnHashTable pawnHash;
+
+		// Static evaluations of whole positions, probed before calling the evaluation
+		EvalCache evalCache;
+
+		// Neural network evaluation, the handcrafted evaluation is used without a network
+		std::unique_ptr<Nnue::Evaluator> nnue;
+
+		std::atomic<std::chrono::steady_clock::time_point> searchStart = std::chrono::steady_clock::now();
+		std::atomic<std::chrono::steady_clock::time_point> searchEnd = std::chrono::steady_clock::now();
+		std::atomic<bool> searching = false;
+
+		// Result of the last completed iteration, published with a sequence lock (odd while writing)
+		std::atomic<uint32_t> infoSequence = 0;
+		std::atomic<bool> infoWhiteToMove = true;
+		std::atomic<int> infoHashFull = 0;
+		std::atomic<int> infoLineCount = 0;
+		std::array<std::atomic<int>, maxMultiPV> infoEvaluation = {};
+		std::array<std::atomic<int>, maxMultiPV> infoPVLength = {};
+		std::array<std::array<std::atomic<uint16_t>, maxPly>, maxMultiPV> infoPV = {};
+
+		SearchInfoCallback infoCallback;
 
 		int evaluation = 0;
 		
@@ -29,12 +149,23 @@ namespace Chess
 		std::array<int, Consts::MaxPossibleMoves> moveScores = {};
 		size_t movesSize = 0;
 
-		// Store already evaluated positions
+		// Store already evaluated positions, no new entries are added once the capacity is reached
 		std::unordered_map<uint64_t, int, VoidHasher> transpositionTable = {};
+		size_t transpositionTableCapacity = transpositionTableSize;
 
-		// Store moves that caused alpha beta cutoff for white and black (killer moves)
+		// Butterfly history of quiet moves for white and black, indexed by [from][to]
 		std::array<std::array<std::array<int, 64>, 64>, 2> moveHistory = {};
 
+		// Two quiet moves per ply that caused a beta cutoff (killer moves)
+		std::array<std::array<Move, 2>, maxPly> killerMoves = {};
+
+		// Quiet move that refuted the previous move, indexed by previous [from][to]
+		std::array<std::array<Move, 64>, 64> counterMoves = {};
+
+		// History of quiet moves indexed by previous piece and square, then by moved piece and square
+		// (~1.8MB so it is allocated on the heap)
+		std::unique_ptr<std::array<PieceToHistory, Consts::TotalBitboards * 64>> continuationHistory;
+
 		// Store best moves for each encountered position
 		std::unordered_map<uint64_t, Move> PVTable = {};
 
@@ -43,25 +174,93 @@ namespace Chess
 	public:
 		Search()
 		{
-			transpositionTable.reserve(10'000'000);
-			stats = { 0, 0, 0, 0, 0 };
+			transpositionTable.reserve(transpositionTableSize);
+			continuationHistory = std::make_unique<std::array<PieceToHistory, Consts::TotalBitboards * 64>>();
+			initReductions();
+			setNetwork(Nnue::defaultNetwork());
 		}
 
-		Move searchBestMove(ChessBoard& board);
+		static void initReductions();
+
+		// Stops when stopToken is requested, stopSearch is called or the time limit is reached
+		Move searchBestMove(ChessBoard& board, std::stop_token stopToken = {});
 		void search(int depth);
-		void orderMoves(std::array<Move, Consts::MaxPossibleMoves>& moves, int moveSize);
+		void orderMoves(std::array<Move, Consts::MaxPossibleMoves>& moves, int moveSize, int ply, Move previousMove);
+
+		// Not thread-safe, set it before starting the search
+		void setInfoCallback(SearchInfoCallback callback) { infoCallback = std::move(callback); };
+
+		// Safe to call from any thread while searching
+		SearchStats getSearchStats() const;
+		SearchInfo getSearchInfo() const;
+
+		const SearchParameters& getParameters() const { return params; };
+		void setParameters(const SearchParameters& newParams) { params = newParams; };
+
+		// Time limits for the next searchBestMove call, without them the search runs until stopSearch
+		void setTimeLimits(std::chrono::milliseconds timeLeft, std::chrono::milliseconds increment, int movesToGo);
+		void setMoveTime(std::chrono::milliseconds moveTime);
 
-		SearchStats getSearchStats() const { return stats; };
+		// Depth and node limits for the next searchBestMove call. Without time limits the result only
+		// depends on the position and the tables left by previous searches (clearHistory for a fresh start)
+		void setDepthLimit(int depth) { depthLimit = depth; };
+		void setNodeLimit(uint64_t nodes) { nodeLimit = nodes; };
 
-		void stopSearch() { abortSearch = true; };
+		void setMultiPV(int lines) { multiPV = std::clamp(lines, 1, maxMultiPV); };
+		int getMultiPV() const { return multiPV; };
+
+		// Makes the next searchBestMove a ponder search, call before starting the search thread
+		void startPondering() { pondering = true; };
+		bool isPondering() const { return pondering; };
+
+		// The expected move was played, continue as a normal timed search (thread-safe)
+		void ponderHit();
+
+		void stopSearch();
 		int getEvaluation() { return evaluation; };
 
 		//int Minimax(int depth, bool maximizingPlayer);
 		//int Negamax(int depth);
-		int alphaBetaPruning(int depth, int alpha, int beta);
-		int QuiescenceSearch(int alpha, int beta);
+		int alphaBetaPruning(int depth, int ply, int alpha, int beta);
+		int QuiescenceSearch(int depth, int ply, int alpha, int beta);
 
 		void clearHistory();
 
+		// Resizes (and clears) the transposition table, not thread-safe
+		void setHashSize(int megabytes);
+
+		// Evaluates with the network (it has to outlive the search) or the handcrafted evaluation
+		// for nullptr, not thread-safe
+		void setNetwork(const Nnue::Network* network);
+		bool usesNetwork() const { return nnue != nullptr; };
+
+		// Material balance after all captures on the target square, from the moving side's perspective
+		int staticExchangeEvaluation(const Move& move) const;
+
+	private:
+		// Static evaluation of the current position from the side to move, cached. Outside of (alpha, beta)
+		// by more than the lazy margin the evaluation may stop early, such scores are not cached
+		int evaluate(int alpha = Evaluation::NegInfinity, int beta = Evaluation::PosInfinity);
+
+		void checkLimits();
+		void publishSearchInfo();
+		int extractPrincipalVariation(Move firstMove, std::array<Move, maxPly>& principalVariation);
+		std::chrono::milliseconds getElapsed() const;
+
+		PieceToHistory* getContinuationHistory(Move previousMove);
+		void updateQuietHistories(Move bestMove, const std::array<Move, Consts::MaxPossibleMoves>& quietsTried,
+			int quietsCount, int depth, int ply, Move previousMove);
+
+		// Mate scores are stored relative to the stored position and loaded relative to the root
+		static int scoreToTT(int score, int ply);
+		static int scoreFromTT(int score, int ply);
+
+		// Gravity update, moves the entry towards the bonus while keeping it within maxHistory
+		template <typename T>
+		static void applyHistoryBonus(T& entry, int bonus)
+		{
+			entry += bonus - entry * std::abs(bonus) / maxHistory;
+		}
+
 	};
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+namespace Chess
+{
+	// Tunable search parameters, every pruning technique can be switched off separately for A/B testing
+	struct SearchParameters
+	{
+		// Extend positions where the side to move is in check
+		bool checkExtensions = true;
+
+		// Null move pruning
+		bool nullMovePruning = true;
+		int nullMoveMinDepth = 5;
+		int nullMoveReduction = 2;
+
+		// Late move reductions
+		bool lateMoveReductions = true;
+		int lateMoveIndex = 3;
+		int lmrMinDepth = 3;
+
+		// Late move pruning, skip quiet moves after (lmpBaseMoves + depth * depth) moves
+		bool lateMovePruning = true;
+		int lmpMaxDepth = 3;
+		int lmpBaseMoves = 4;
+
+		// Reverse futility (static null move) pruning, static eval - margin * depth >= beta
+		bool reverseFutilityPruning = true;
+		int reverseFutilityMaxDepth = 6;
+		int reverseFutilityMargin = 90;
+
+		// Razoring, drop into quiescence search when static eval + margin * depth < alpha
+		bool razoring = true;
+		int razoringMaxDepth = 2;
+		int razoringMargin = 250;
+
+		// Futility pruning of quiet moves, static eval + base + margin * depth <= alpha
+		bool futilityPruning = true;
+		int futilityMaxDepth = 3;
+		int futilityBaseMargin = 100;
+		int futilityMargin = 120;
+
+		// Internal iterative deepening, PV nodes without a best move are searched at depth - reduction first
+		bool internalIterativeDeepening = true;
+		int iidMinDepth = 5;
+		int iidReduction = 2;
+
+		// Internal iterative reductions, other nodes without a best move are searched one ply shallower
+		bool internalIterativeReductions = false;
+		int iirMinDepth = 4;
+
+		// Quiescence search, search quiet checks on the first ply
+		bool quiescenceChecks = true;
+
+		// Quiescence search, skip captures that lose material or cannot raise alpha
+		bool seePruning = true;
+		bool deltaPruning = true;
+		int deltaMargin = 200;
+
+		// Lazy evaluation in the quiescence search, stop after material, piece-square tables and pawns
+		// when they are outside of (alpha - margin, beta + margin)
+		bool lazyEvaluation = true;
+		int lazyMargin = 400;
+	};
+}
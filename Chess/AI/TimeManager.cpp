@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "TimeManager.h"
+
+namespace Chess
+{
+	void TimeManager::start(std::chrono::milliseconds timeLeft, std::chrono::milliseconds increment, int movesToGo)
+	{
+		startInfinite();
+
+		int moves = movesToGo > 0 ? std::min(movesToGo, maxMovesToGo) : defaultMovesToGo;
+
+		// keep a safety buffer for communication and thread start up
+		std::chrono::milliseconds available = std::max(timeLeft - moveOverhead, std::chrono::milliseconds(1));
+
+		softLimit = available / moves + increment * 3 / 4;
+		softLimit = std::min(softLimit, available);
+
+		auto maxTime = std::chrono::milliseconds(static_cast<long long>(available.count() * maxTimeFraction));
+		hardLimit = std::chrono::milliseconds(static_cast<long long>(softLimit.count() * hardLimitFactor));
+		hardLimit = std::clamp(hardLimit, softLimit, std::max(maxTime, softLimit));
+
+		limited = true;
+	}
+
+	void TimeManager::startFixed(std::chrono::milliseconds moveTime)
+	{
+		startInfinite();
+
+		softLimit = std::max(moveTime - moveOverhead, std::chrono::milliseconds(1));
+		hardLimit = softLimit;
+
+		limited = true;
+	}
+
+	void TimeManager::startInfinite()
+	{
+		startTime = Clock::now();
+		softLimit = std::chrono::milliseconds(0);
+		hardLimit = std::chrono::milliseconds(0);
+		limited = false;
+
+		bestMoveChanges = 0.0;
+		scoreScale = 1.0;
+		previousBestMove = {};
+		previousScore = 0;
+		previousMate = false;
+		iterations = 0;
+	}
+
+	void TimeManager::restartClock()
+	{
+		startTime.store(Clock::now(), std::memory_order_release);
+	}
+
+	void TimeManager::updateIteration(Move bestMove, int score, bool isMate)
+	{
+		// older changes matter less
+		bestMoveChanges *= 0.5;
+
+		if (iterations > 0 && bestMove != previousBestMove)
+		{
+			bestMoveChanges += 1.0;
+		}
+
+		// spend more time when the score falls, mate scores are left out
+		scoreScale = 1.0;
+
+		int scoreDrop = previousScore - score;
+
+		if (iterations > 0 && !isMate && !previousMate && scoreDrop > scoreDropMargin)
+		{
+			scoreScale = std::min(1.0 + scoreDrop * scoreDropFactor, maxScoreDropScale);
+		}
+
+		previousBestMove = bestMove;
+		previousScore = score;
+		previousMate = isMate;
+		iterations++;
+	}
+
+	bool TimeManager::shouldStartIteration() const
+	{
+		if (!limited)
+		{
+			return true;
+		}
+
+		double scale = (1.0 + bestMoveChanges * bestMoveChangeFactor) * scoreScale;
+		auto scaledSoftLimit = std::chrono::milliseconds(static_cast<long long>(softLimit.count() * scale));
+
+		// the next iteration usually takes longer than all previous ones
+		return getElapsed() < std::min(scaledSoftLimit, hardLimit) / 2;
+	}
+
+	bool TimeManager::isHardLimitReached() const
+	{
+		return limited && getElapsed() >= hardLimit;
+	}
+
+	std::chrono::milliseconds TimeManager::getElapsed() const
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime.load(std::memory_order_acquire));
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "Move.h"
+
+namespace Chess
+{
+	// Allocates search time from the game clock and decides when iterative deepening should stop
+	class TimeManager
+	{
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr int defaultMovesToGo = 40;
+		static constexpr int maxMovesToGo = 50;
+		static constexpr std::chrono::milliseconds moveOverhead = std::chrono::milliseconds(30);
+
+		// hard limit is a multiple of the soft limit, but never more than a fraction of the remaining time
+		static constexpr double hardLimitFactor = 4.0;
+		static constexpr double maxTimeFraction = 0.25;
+
+		// soft limit scaling when the best move changes or the score drops between iterations
+		static constexpr double bestMoveChangeFactor = 0.35;
+		static constexpr double scoreDropFactor = 0.01;
+		static constexpr double maxScoreDropScale = 1.6;
+		static constexpr int scoreDropMargin = 20;
+
+		// restarted from another thread on a ponder hit
+		std::atomic<Clock::time_point> startTime = Clock::now();
+		std::chrono::milliseconds softLimit = std::chrono::milliseconds(0);
+		std::chrono::milliseconds hardLimit = std::chrono::milliseconds(0);
+		bool limited = false;
+
+		// stability of the previous iterations
+		double bestMoveChanges = 0.0;
+		double scoreScale = 1.0;
+		Move previousBestMove = {};
+		int previousScore = 0;
+		bool previousMate = false;
+		int iterations = 0;
+
+	public:
+		// Starts the clock and allocates soft and hard limits (movesToGo = 0 if unknown)
+		void start(std::chrono::milliseconds timeLeft, std::chrono::milliseconds increment, int movesToGo);
+
+		// Starts the clock with a fixed time for the move
+		void startFixed(std::chrono::milliseconds moveTime);
+
+		// Starts the clock without any time limit
+		void startInfinite();
+
+		// Keeps the limits but measures them from now, safe to call while searching
+		void restartClock();
+
+		// Called after every completed iteration, mate scores (as classified by the search) never count as a drop
+		void updateIteration(Move bestMove, int score, bool isMate);
+
+		bool shouldStartIteration() const;
+		bool isHardLimitReached() const;
+		bool isLimited() const { return limited; };
+
+		std::chrono::milliseconds getElapsed() const;
+		std::chrono::milliseconds getSoftLimit() const { return softLimit; };
+		std::chrono::milliseconds getHardLimit() const { return hardLimit; };
+	};
+}
@@ -9,11 +9,47 @@
 #include "GameState.h"
 #include "ChessBoardConsts.h"
 #include "Masks.h"
+#include "MaterialKey.h"
 
 
 
 namespace Chess
 {
+	// Evaluation terms updated on every move instead of being recomputed from the bitboards
+	struct EvalAccumulator
+	{
+		// piece-square sums, white minus black (black squares are flipped to white's side)
+		int mgPST = 0;
+		int egPST = 0;
+
+		// game phase weights of all pieces on the board
+		int gamePhase = 0;
+
+		// zobrist key of the pawns only, indexes the pawn hash table
+		uint64_t pawnKey = 0ULL;
+
+		// piece counts (see MaterialKey.h), selects the specialized endgames
+		uint64_t materialKey = 0ULL;
+
+		bool operator==(const EvalAccumulator&) const = default;
+	};
+
+	// Squares attacked by the pieces of one side, sliders see through the enemy king like in the threat map
+	struct AttackTable
+	{
+		static constexpr int maxPieces = 16;
+
+		uint64_t all = 0ULL;
+
+		// union of the attacks of every piece type, indexed like Pieces.h without the color
+		std::array<uint64_t, 7> byType{};
+
+		// attacks of every knight, bishop, rook and queen separately
+		std::array<uint64_t, maxPieces> pieceAttacks;
+		std::array<int, maxPieces> pieceTypes;
+		int pieceCount = 0;
+	};
+
 	class ChessBoard : private Consts
 	{
 		// Position information
@@ -30,12 +66,18 @@ namespace Chess
 
 		// Making/unmaking a move
 		uint64_t zobristKey = 0ULL;
+		EvalAccumulator accumulator;
+
+		// Attack tables of the current position ([0] for black [1] for white), computed on first use
+		mutable std::array<AttackTable, 2> attackTables;
+		mutable std::array<bool, 2> attackTablesValid{};
 
 		// Stack pointer serves the role to track indices of pastStates, bitboards etc
 		int stackPointer = -1;
 		std::array<std::array<uint64_t, TotalBitboards>, stackSize> pastPositions;
 		std::array<GameState, stackSize> pastGameStates;
 		std::array<uint64_t, stackSize> pastZobristKeys;
+		std::array<EvalAccumulator, stackSize> pastAccumulators;
 
 	public:
 		ChessBoard();
@@ -57,6 +99,7 @@ namespace Chess
 		GameState& getGameStateRef() { return gameState; }
 		size_t getMovesSize() const { return lastMoveIndex; }
 		uint64_t getZobristKey() const { return zobristKey; }
+		const EvalAccumulator& getAccumulator() const { return accumulator; }
 		Piece getPiece(uint64_t square) const;
 		Piece getPieceType(int index) const;
 		//Piece getPieceType(uint64_t piecePos) const;
@@ -64,6 +107,7 @@ namespace Chess
 		// Move generation
 		size_t generateMovesToDepth(int depth);
 		void generateMoves(bool genQuiets = true);
+		void generateCapturesAndChecks();
 
 		// Masks & threatMaps
 		uint64_t computeCheckMask(bool white, uint64_t kingMask) const;
@@ -72,6 +116,9 @@ namespace Chess
 		uint64_t getCheckMask(bool white) const;
 		uint64_t getPinMask(bool white) const;
 		uint64_t getThreatMap(bool white) const;
+		// same squares as the threat map, kept until the position changes (shared by evaluation and move generation)
+		const AttackTable& getAttackTable(bool white) const;
+		AttackTable computeAttackTable(bool white) const;
 		// returns threatmap for opponent, checkmask and pinmask for self
 		const Masks& getMasks() const { return masks; };
 
@@ -80,6 +127,11 @@ namespace Chess
 		// pops last move from gameState
 		void unmakeMove();
 		bool canUnmakeMove() const { return stackPointer >= 0; };
+
+		// Positions on the make/unmake stack, ply 0 is the oldest one and getPly() the current one
+		int getPly() const { return stackPointer + 1; };
+		const std::array<uint64_t, TotalBitboards>& getBitboardsAt(int ply) const { return ply <= stackPointer ? pastPositions[ply] : bitboards; };
+		uint64_t getZobristKeyAt(int ply) const { return ply <= stackPointer ? pastZobristKeys[ply] : zobristKey; };
 			
 		// Make unmake special moves
 		void handlePromotionMove(uint64_t pawn, Piece newPiece, Piece pawnColor);
@@ -89,6 +141,11 @@ namespace Chess
 		void rollbackCastlingMove(uint64_t king, Piece friendlyRook, Move::Flag castlingType);
 		void updateCastlingRights(uint64_t fromMask, uint64_t toMask, bool white);
 
+		// Accumulator of the current bitboards from scratch, the incremental one has to match it
+		EvalAccumulator computeAccumulator() const;
+		// Applies the pieces that were added or removed since the previous bitboards
+		void updateAccumulator(const std::array<uint64_t, TotalBitboards>& previousBitboards);
+
 		// Utility methods
 		uint64_t getOccupiedSquares(bool white) const;
 		uint64_t getOccupiedSquares() const;
@@ -122,6 +179,11 @@ namespace Chess
 		uint64_t getThreatMapforVertical(uint64_t pieces, bool white) const;
 		uint64_t getThreatMapforQueen(uint64_t queens, bool white) const;
 
+		// Attacks and attackers for a custom occupancy (used by static exchange evaluation)
+		static uint64_t getDiagonalAttacks(int square, uint64_t occupiedSquares);
+		static uint64_t getVerticalAttacks(int square, uint64_t occupiedSquares);
+		uint64_t getAttackersTo(int square, uint64_t occupiedSquares) const;
+
 		// Copying
 		ChessBoard shallowCopy();	// copies only current gameState and position, no pastPositions and gameStates
 		std::array<uint64_t, TotalBitboards> getBitboards() const;
@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <bit>
 #include <string>
 #include <iostream>
 #include <sstream>
 
 #include "ChessBoard.h"
+#include "PieceSquareTables.h"
 #include "Zobrist.h"
 
 namespace Chess
@@ -127,6 +129,8 @@ namespace Chess
 		pastPositions[stackPointer] = bitboards;
 		pastGameStates[stackPointer] = gameState;
 		pastZobristKeys[stackPointer] = zobristKey;
+		pastAccumulators[stackPointer] = accumulator;
+		attackTablesValid = {};
 
 		int colorMask = whiteToMove ? Piece::White : Piece::Black;
 		int oppositeColorMask = whiteToMove ? Piece::Black : Piece::White;
@@ -199,6 +203,9 @@ namespace Chess
 			gameState.setEnPassantSquare(-1);
 		}
 
+		// captures, promotions and castling are all seen as changed bitboards
+		updateAccumulator(pastPositions[stackPointer]);
+
 		// update castling rights for both kings
 		updateCastlingRights(fromMask, toMask, whiteToMove);
 		updateCastlingRights(fromMask, toMask, !whiteToMove);
@@ -220,24 +227,13 @@ namespace Chess
 		int repetition = std::count(pastZobristKeys.begin(), pastZobristKeys.begin() + stackPointer, zobristKey);
 		if (repetition >= 2)
 		{
-			std::cout << "Stalemate repetition";
 			gameState.setStalemate();
 		}
 
 		// knight king, bishop king endgame
-		uint64_t heavyPieces = bitboards[Piece::WhiteRook] | bitboards[Piece::BlackRook] | bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen];
-		uint64_t pawns = bitboards[Piece::WhitePawn] | bitboards[Piece::BlackPawn];
-
-		if (std::popcount(heavyPieces | pawns) == 0)
+		if (MaterialKey::isInsufficientMaterial(accumulator.materialKey))
 		{
-			uint64_t lightPiecesWhite = bitboards[Piece::WhiteKnight] | bitboards[Piece::WhiteBishop];
-			uint64_t lightPiecesBlack = bitboards[Piece::BlackKnight] | bitboards[Piece::BlackBishop];
-
-			if (std::popcount(lightPiecesWhite) <= 1 && std::popcount(lightPiecesBlack) <= 1)
-			{
-				gameState.setStalemate();
-				std::cout << "Stalemate Insufficient material";
-			}
+			gameState.setStalemate();
 		}
 	}
 
@@ -266,6 +262,8 @@ namespace Chess
 		bitboards = pastPositions[stackPointer];
 		gameState = pastGameStates[stackPointer];
 		zobristKey = pastZobristKeys[stackPointer];
+		accumulator = pastAccumulators[stackPointer];
+		attackTablesValid = {};
 		stackPointer--;
 
 		whiteToMove = !whiteToMove;
@@ -325,6 +323,106 @@ namespace Chess
 	}
 
 
+	EvalAccumulator ChessBoard::computeAccumulator() const
+	{
+		EvalAccumulator result;
+
+		for (int i = Piece::WhiteRook; i <= Piece::BlackPawn; i++)
+		{
+			uint64_t pieces = bitboards[i];
+			int type = i & ~Piece::Black;
+
+			// indices between the white and black pieces are empty
+			if (type < Piece::Rook || type > Piece::Pawn)
+			{
+				continue;
+			}
+
+			while (pieces)
+			{
+				// tables are written from white's side, square 0 is a8
+				int square = std::countr_zero(pieces);
+				int tableSquare = (i & Piece::Black) ? square ^ 56 : square;
+				int sign = (i & Piece::Black) ? -1 : 1;
+
+				result.mgPST += sign * Evaluation::mg_pestoTable[type][tableSquare];
+				result.egPST += sign * Evaluation::eg_pestoTable[type][tableSquare];
+				result.gamePhase += Evaluation::gamePhaseWeights[type];
+
+				if (type == Piece::Pawn)
+				{
+					result.pawnKey ^= Zobrist::piecesArray[i][square];
+				}
+
+				if (type != Piece::King)
+				{
+					result.materialKey += MaterialKey::piece(i);
+				}
+
+				pieces &= (pieces - 1);
+			}
+		}
+
+		return result;
+	}
+
+	void ChessBoard::updateAccumulator(const std::array<uint64_t, TotalBitboards>& previousBitboards)
+	{
+		for (int i = Piece::WhiteRook; i <= Piece::BlackPawn; i++)
+		{
+			uint64_t removed = previousBitboards[i] & ~bitboards[i];
+			uint64_t added = bitboards[i] & ~previousBitboards[i];
+
+			if ((removed | added) == 0ULL)
+			{
+				continue;
+			}
+
+			int type = i & ~Piece::Black;
+			int flip = (i & Piece::Black) ? 56 : 0;
+			int sign = (i & Piece::Black) ? -1 : 1;
+
+			// a moved piece is removed and added, the count only changes with captures and promotions
+			if (type != Piece::King)
+			{
+				accumulator.materialKey += (std::popcount(added) - std::popcount(removed)) * MaterialKey::piece(i);
+			}
+
+			if (type == Piece::Pawn)
+			{
+				uint64_t changed = removed | added;
+
+				while (changed)
+				{
+					accumulator.pawnKey ^= Zobrist::piecesArray[i][std::countr_zero(changed)];
+					changed &= (changed - 1);
+				}
+			}
+
+			while (removed)
+			{
+				int square = std::countr_zero(removed) ^ flip;
+
+				accumulator.mgPST -= sign * Evaluation::mg_pestoTable[type][square];
+				accumulator.egPST -= sign * Evaluation::eg_pestoTable[type][square];
+				accumulator.gamePhase -= Evaluation::gamePhaseWeights[type];
+
+				removed &= (removed - 1);
+			}
+
+			while (added)
+			{
+				int square = std::countr_zero(added) ^ flip;
+
+				accumulator.mgPST += sign * Evaluation::mg_pestoTable[type][square];
+				accumulator.egPST += sign * Evaluation::eg_pestoTable[type][square];
+				accumulator.gamePhase += Evaluation::gamePhaseWeights[type];
+
+				added &= (added - 1);
+			}
+		}
+	}
+
 	// Starting a8 to h1 or horizontal left to right, top to bottom
 	std::array<Piece, 64> ChessBoard::getBoardAsArray() const
 	{
@@ -373,8 +471,13 @@ namespace Chess
 
 		size_t count = 0;
 
-		for (const auto& move : legalMoves)
+		// the recursion overwrites legalMoves, so iterate over a copy of the generated moves
+		std::array<Move, MaxPossibleMoves> legalMovesCopy = legalMoves;
+		size_t movesSize = lastMoveIndex;
+
+		for (size_t i = 0; i < movesSize; i++)
 		{
+			const Move& move = legalMovesCopy[i];
 			makeMove(move);
 			count += generateMovesToDepth(depth - 1);
 			unmakeMove();
@@ -390,8 +493,12 @@ namespace Chess
 
 		std::cout << "Depth: " << depth << std::endl;
 
-		for (const auto& move : legalMoves)
+		std::array<Move, MaxPossibleMoves> legalMovesCopy = legalMoves;
+		size_t movesSize = lastMoveIndex;
+
+		for (size_t i = 0; i < movesSize; i++)
 		{
+			const Move& move = legalMovesCopy[i];
 			makeMove(move);
 			int moves = generateMovesToDepth(depth - 1);
 			nodesSearched += moves;
@@ -410,8 +517,12 @@ namespace Chess
 		if (depth < 1) return 0;
 		if (depth == 1) return lastMoveIndex;
 
-		for (const auto& move : legalMoves)
+		std::array<Move, MaxPossibleMoves> legalMovesCopy = legalMoves;
+		size_t movesSize = lastMoveIndex;
+
+		for (size_t i = 0; i < movesSize; i++)
 		{
+			const Move& move = legalMovesCopy[i];
 			makeMove(move);
 			int moves = generateMovesToDepth(depth - 1);
 			nodesSearched += moves;
@@ -427,7 +538,7 @@ namespace Chess
 
 		int colorMask = whiteToMove ? Piece::White : Piece::Black;
 		
-		masks = Masks{ getThreatMap(!whiteToMove), 0xffffffffffffffff, computeHVPinMask(whiteToMove), computeD12PinMask(whiteToMove) };
+		masks = Masks{ getAttackTable(!whiteToMove).all, 0xffffffffffffffff, computeHVPinMask(whiteToMove), computeD12PinMask(whiteToMove) };
 
 		bool kingInCheck = isKingInCheck(whiteToMove, masks.threatMap);
 
@@ -446,7 +557,8 @@ namespace Chess
 		generateSlidingDiagonalMoves(bitboards[Piece::Queen | colorMask], whiteToMove, genQuiets);		// Queens (diagonal and vertiacl move generation)
 		generateSlidingVerticalMoves(bitboards[Piece::Queen | colorMask], whiteToMove, genQuiets);		// Queens
 
-		if (lastMoveIndex == 0)
+		// captures only generation cannot decide if the game is over
+		if (lastMoveIndex == 0 && genQuiets)
 		{
 			if (kingInCheck)
 			{
@@ -459,12 +571,76 @@ namespace Chess
 		}
 	}
 
-	// get square from and square to as a string
+	// Generates all legal moves and keeps captures, promotions and quiet moves giving a direct check
+	void ChessBoard::generateCapturesAndChecks()
+	{
+		generateMoves();
+
+		int colorMask = whiteToMove ? Piece::White : Piece::Black;
+		uint64_t enemyKing = bitboards[Piece::King | (whiteToMove ? Piece::Black : Piece::White)];
+		int enemyKingSquare = std::countr_zero(enemyKing);
+
+		uint64_t occupiedSquares = getOccupiedSquares();
+		uint64_t occupiedByEnemy = getOccupiedSquares(!whiteToMove);
+
+		uint64_t diagonalChecks = getDiagonalAttacks(enemyKingSquare, occupiedSquares);
+		uint64_t verticalChecks = getVerticalAttacks(enemyKingSquare, occupiedSquares);
+
+		// squares from which each piece type attacks the enemy king, indexed by Piece
+		std::array<uint64_t, 7> checkSquares = {};
+		checkSquares[Piece::Rook] = verticalChecks;
+		checkSquares[Piece::Knight] = getThreatMapforKnight(enemyKing);
+		checkSquares[Piece::Bishop] = diagonalChecks;
+		checkSquares[Piece::Queen] = diagonalChecks | verticalChecks;
+		checkSquares[Piece::Pawn] = getThreatMapforPawn(enemyKing, !whiteToMove);
+
+		size_t noisyMovesSize = 0;
+
+		for (size_t i = 0; i < lastMoveIndex; i++)
+		{
+			const Move& move = legalMoves[i];
+			uint64_t toMask = 1ULL << move.to;
+
+			bool isNoisy = (toMask & occupiedByEnemy) || move.isPromotion() || move.isEnPassant();
+			bool isCheck = false;
+
+			if (!isNoisy && !move.isCastling())
+			{
+				uint64_t fromMask = 1ULL << move.from;
+
+				for (int piece = Piece::Rook; piece <= Piece::Pawn; piece++)
+				{
+					if (bitboards[piece | colorMask] & fromMask)
+					{
+						isCheck = checkSquares[piece] & toMask;
+						break;
+					}
+				}
+			}
+
+			if (isNoisy || isCheck)
+			{
+				legalMoves[noisyMovesSize++] = move;
+			}
+		}
+
+		lastMoveIndex = noisyMovesSize;
+	}
+
+	// get square from and square to as a string, promotions get the piece appended (e7e8q)
 	std::string ChessBoard::toChessNotation(Move move)
 	{
 		std::string from = std::string(1, 'a' + (move.from % 8)) + std::to_string(8 - (move.from / 8));
 		std::string to = std::string(1, 'a' + (move.to % 8)) + std::to_string(8 - (move.to / 8));
-		return from + to;
+
+		switch (move.flag)
+		{
+		case Move::PromotionQueen: return from + to + "q";
+		case Move::PromotionRook: return from + to + "r";
+		case Move::PromotionBishop: return from + to + "b";
+		case Move::PromotionKnight: return from + to + "n";
+		default: return from + to;
+		}
 	}
 
 	std::string ChessBoard::indexToCoord(int index)
@@ -484,6 +660,74 @@ namespace Chess
 			getThreatMapforVertical(bitboards[Piece::BlackRook], false) | getThreatMapforQueen(bitboards[Piece::BlackQueen], false);
 	}
 
+	const AttackTable& ChessBoard::getAttackTable(bool white) const
+	{
+		if (!attackTablesValid[white])
+		{
+			attackTables[white] = computeAttackTable(white);
+			attackTablesValid[white] = true;
+		}
+
+		return attackTables[white];
+	}
+
+	AttackTable ChessBoard::computeAttackTable(bool white) const
+	{
+		int colorMask = white ? Piece::White : Piece::Black;
+		uint64_t enemyKing = bitboards[Piece::King | (white ? Piece::Black : Piece::White)];
+
+		// Exclude enemy king, so the sliders go through it
+		uint64_t occupiedSquares = getOccupiedSquares() & ~enemyKing;
+
+		AttackTable table;
+
+		table.byType[Piece::Pawn] = getThreatMapforPawn(bitboards[Piece::Pawn | colorMask], white);
+		table.byType[Piece::King] = getThreatMapforKing(bitboards[Piece::King | colorMask]);
+
+		for (int type : { Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen })
+		{
+			uint64_t pieces = bitboards[type | colorMask];
+
+			while (pieces)
+			{
+				int square = std::countr_zero(pieces);
+				uint64_t attacks = 0ULL;
+
+				if (type == Piece::Knight)
+				{
+					attacks = getThreatMapforKnight(1ULL << square);
+				}
+				if (type == Piece::Bishop || type == Piece::Queen)
+				{
+					attacks |= getDiagonalAttacks(square, occupiedSquares);
+				}
+				if (type == Piece::Rook || type == Piece::Queen)
+				{
+					attacks |= getVerticalAttacks(square, occupiedSquares);
+				}
+
+				table.byType[type] |= attacks;
+
+				// at most 15 pieces besides pawns and the king, the guard only protects against invalid positions
+				if (table.pieceCount < AttackTable::maxPieces)
+				{
+					table.pieceAttacks[table.pieceCount] = attacks;
+					table.pieceTypes[table.pieceCount] = type;
+					table.pieceCount++;
+				}
+
+				pieces &= (pieces - 1);
+			}
+		}
+
+		for (uint64_t attacks : table.byType)
+		{
+			table.all |= attacks;
+		}
+
+		return table;
+	}
+
 	bool ChessBoard::isKingInCheck(bool white) const
 	{
 		return getThreatMap(!white) & (white ? bitboards[Piece::WhiteKing] : bitboards[Piece::BlackKing]);
@@ -645,6 +889,7 @@ namespace Chess
 	{
 		// Reset board
 		bitboards.fill(0);
+		attackTablesValid = {};
 
 		// Split FEN into tokens
 		std::vector<std::string> tokens;
@@ -701,6 +946,8 @@ namespace Chess
 			}
 		}
 
+		accumulator = computeAccumulator();
+
 		// Load side to move
 		whiteToMove = (tokens[1] == "w");
 
@@ -747,6 +994,9 @@ namespace Chess
 		copy.gameState = gameState;
 		copy.whiteToMove = whiteToMove;
 		copy.zobristKey = zobristKey;
+		copy.accumulator = accumulator;
+		copy.attackTables = attackTables;
+		copy.attackTablesValid = attackTablesValid;
 
 		copy.legalMoves = legalMoves;
 		copy.lastMoveIndex = lastMoveIndex;
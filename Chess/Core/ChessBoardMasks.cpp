@@ -11,12 +11,12 @@ namespace Chess
 				bitboards[Piece::BlackRook] | bitboards[Piece::BlackBishop] | bitboards[Piece::BlackQueen]);
 	}
 
-	inline bool ChessBoard::isDiagonalSlider(uint64_t piece) const
+	bool ChessBoard::isDiagonalSlider(uint64_t piece) const
 	{
 		return piece & (bitboards[Piece::WhiteBishop] | bitboards[Piece::BlackBishop] | bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen]);
 	}
 
-	inline bool ChessBoard::isVerticalSlider(uint64_t piece) const
+	bool ChessBoard::isVerticalSlider(uint64_t piece) const
 	{
 		return piece & (bitboards[Piece::WhiteRook] | bitboards[Piece::BlackRook] | bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen]);
 	}
@@ -60,7 +60,7 @@ namespace Chess
 		return checkingPieces | raysBetween[std::countr_zero(checkingPieces)][std::countr_zero(king)];
 	}
 
-	inline uint64_t ChessBoard::computeD12PinMask(bool white) const
+	uint64_t ChessBoard::computeD12PinMask(bool white) const
 	{
 		static const int directions[4] = { -7, 7, -9, 9 };
 
@@ -111,7 +111,7 @@ namespace Chess
 		return pinMask;
 	}
 
-	inline uint64_t ChessBoard::computeHVPinMask(bool white) const
+	uint64_t ChessBoard::computeHVPinMask(bool white) const
 	{
 		static const int directions[8] = { -1, 1, -8, 8 };
 
@@ -172,4 +172,79 @@ namespace Chess
 	{
 		return computeCheckMask(white, bitboards[white ? Piece::WhiteKing : Piece::BlackKing]);
 	}
-}
\ No newline at end of file
+
+	uint64_t ChessBoard::getDiagonalAttacks(int square, uint64_t occupiedSquares)
+	{
+		static constexpr int directions[4] = { 7, -7, 9, -9 };
+
+		uint64_t attacks = 0ULL;
+
+		for (const auto& dir : directions)
+		{
+			uint64_t curPos = 1ULL << square;
+
+			while (true)
+			{
+				if ((dir == 7) && (curPos & (COL1 | ROW8))) break;		// BOTTOM-LEFT
+				if ((dir == -7) && (curPos & (COL8 | ROW1))) break;		// TOP-RIGHT
+				if ((dir == 9) && (curPos & (COL8 | ROW8))) break;		// BOTTOM-RIGHT
+				if ((dir == -9) && (curPos & (COL1 | ROW1))) break;		// TOP-LEFT
+
+				curPos = dir > 0 ? curPos << dir : curPos >> -dir;
+				attacks |= curPos;
+
+				if (occupiedSquares & curPos) break;
+			}
+		}
+
+		return attacks;
+	}
+
+	uint64_t ChessBoard::getVerticalAttacks(int square, uint64_t occupiedSquares)
+	{
+		static constexpr int directions[4] = { 1, -1, 8, -8 };
+
+		uint64_t attacks = 0ULL;
+
+		for (const auto& dir : directions)
+		{
+			uint64_t curPos = 1ULL << square;
+
+			while (true)
+			{
+				if ((dir == 1) && (curPos & COL8)) break;	// RIGHT
+				if ((dir == -1) && (curPos & COL1)) break;	// LEFT
+				if ((dir == 8) && (curPos & ROW8)) break;	// BOTTOM
+				if ((dir == -8) && (curPos & ROW1)) break;	// TOP
+
+				curPos = dir > 0 ? curPos << dir : curPos >> -dir;
+				attacks |= curPos;
+
+				if (occupiedSquares & curPos) break;
+			}
+		}
+
+		return attacks;
+	}
+
+	// Pieces of both colors attacking the square, sliders are blocked by occupiedSquares
+	uint64_t ChessBoard::getAttackersTo(int square, uint64_t occupiedSquares) const
+	{
+		uint64_t squareMask = 1ULL << square;
+
+		uint64_t diagonalSliders = bitboards[Piece::WhiteBishop] | bitboards[Piece::BlackBishop] | bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen];
+		uint64_t verticalSliders = bitboards[Piece::WhiteRook] | bitboards[Piece::BlackRook] | bitboards[Piece::WhiteQueen] | bitboards[Piece::BlackQueen];
+
+		// white pawns attacking the square stand where a black pawn from the square would capture (and vice versa)
+		uint64_t attackers = 0ULL;
+
+		attackers |= getThreatMapforPawn(squareMask, false) & bitboards[Piece::WhitePawn];
+		attackers |= getThreatMapforPawn(squareMask, true) & bitboards[Piece::BlackPawn];
+		attackers |= getThreatMapforKnight(squareMask) & (bitboards[Piece::WhiteKnight] | bitboards[Piece::BlackKnight]);
+		attackers |= getThreatMapforKing(squareMask) & (bitboards[Piece::WhiteKing] | bitboards[Piece::BlackKing]);
+		attackers |= getDiagonalAttacks(square, occupiedSquares) & diagonalSliders;
+		attackers |= getVerticalAttacks(square, occupiedSquares) & verticalSliders;
+
+		return attackers & occupiedSquares;
+	}
+}
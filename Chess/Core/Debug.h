@@ -1,6 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <unordered_map>
+
+#include "Move.h"
 
 namespace Chess
 {
@@ -14,10 +18,29 @@ namespace Chess
 	struct SearchStats
 	{
 		int depth;
-		int nodesVisited;
-		int nodesEvaluated;
-		int nodesPruned;
-		int nodesTransposed;
+		uint64_t nodesVisited;
+		uint64_t nodesEvaluated;
+		uint64_t nodesPruned;
+		uint64_t nodesTransposed;
+		uint64_t nodesPerSecond;
+
+		// pawn structure evaluations found in the pawn hash table
+		uint64_t pawnHashProbes;
+		uint64_t pawnHashHits;
+
+		// static evaluations that stopped after material, piece-square tables and pawns
+		uint64_t lazyEvaluations;
+	};
+
+	// Counter with a single writer (the search thread), other threads may read it at any time.
+	// A relaxed load + store is enough and avoids the cost of an atomic read-modify-write
+	struct RelaxedCounter
+	{
+		std::atomic<uint64_t> value = 0;
+
+		void operator++(int) { value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+		void reset() { value.store(0, std::memory_order_relaxed); }
+		uint64_t load() const { return value.load(std::memory_order_relaxed); }
 	};
 
 	struct DebugData
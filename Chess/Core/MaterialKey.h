@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "Pieces.h"
+
+namespace Chess::MaterialKey
+{
+	// Material of a position packed into 4 bits per piece count, indexed like Pieces.h (kings are not counted).
+	// Every position with the same material has the same key and no other material has it.
+	// The white pieces are in the low and the black pieces in the high 32 bits
+
+	constexpr uint64_t piece(int piece)
+	{
+		return 1ULL << (4 * piece);
+	}
+
+	constexpr int count(uint64_t key, int piece)
+	{
+		return static_cast<int>((key >> (4 * piece)) & 0xf);
+	}
+
+	// black and white swapped
+	constexpr uint64_t mirror(uint64_t key)
+	{
+		return (key << 32) | (key >> 32);
+	}
+
+	constexpr uint64_t whitePieces = 0x00000000'ffffffffULL;
+	constexpr uint64_t blackPieces = 0xffffffff'00000000ULL;
+
+	// Key of an endgame code like "KBNK", the pieces after the first king are white and after the second black
+	constexpr uint64_t fromCode(std::string_view code)
+	{
+		uint64_t key = 0ULL;
+		int color = Piece::Black;
+
+		for (char letter : code)
+		{
+			switch (letter)
+			{
+			case 'K': color = color == Piece::Black ? Piece::White : Piece::Black; break;
+			case 'Q': key += piece(Piece::Queen | color); break;
+			case 'R': key += piece(Piece::Rook | color); break;
+			case 'B': key += piece(Piece::Bishop | color); break;
+			case 'N': key += piece(Piece::Knight | color); break;
+			case 'P': key += piece(Piece::Pawn | color); break;
+			}
+		}
+
+		return key;
+	}
+
+	static_assert(fromCode("KRPKB") == (piece(Piece::WhiteRook) | piece(Piece::WhitePawn) | piece(Piece::BlackBishop)));
+	static_assert(mirror(fromCode("KQKP")) == fromCode("KPKQ"));
+
+	// No pawns, rooks or queens and at most one minor piece per side, nobody can win
+	constexpr bool isInsufficientMaterial(uint64_t key)
+	{
+		constexpr uint64_t pawnsAndMajors =
+			0xfULL * (piece(Piece::WhitePawn) | piece(Piece::WhiteRook) | piece(Piece::WhiteQueen) |
+				piece(Piece::BlackPawn) | piece(Piece::BlackRook) | piece(Piece::BlackQueen));
+
+		return (key & pawnsAndMajors) == 0 &&
+			count(key, Piece::WhiteKnight) + count(key, Piece::WhiteBishop) <= 1 &&
+			count(key, Piece::BlackKnight) + count(key, Piece::BlackBishop) <= 1;
+	}
+}
@@ -7,7 +7,7 @@ namespace Chess
 	private:
 		static constexpr uint16_t FROM = 0b111111;	// bits 0 - 5
 		static constexpr uint16_t TO = FROM << 6;	// bits 6 - 11
-		static constexpr uint16_t FLAG = FROM << 12;	// bits 12...
+		static constexpr uint16_t FLAG = 0b1111 << 12;	// bits 12 - 15
 
 	public:
 		// Values of Pieces are equal to Promotion ones (DO NOT CHANGE)
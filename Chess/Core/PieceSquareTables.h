@@ -157,5 +157,15 @@ namespace Chess::Evaluation
         eg_kingTable.data(),
         eg_pawnTable.data(),
     };
-}
 
+    // Game phase weight of each piece type, pawns and castling rights are added by the evaluation
+    constexpr std::array<int, 7> gamePhaseWeights = {
+        0,      // None
+        5,      // Rook
+        3,      // Knight
+        4,      // Bishop
+        10,     // Queen
+        0,      // King
+        0       // Pawn
+    };
+}
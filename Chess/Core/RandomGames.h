@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "ChessBoard.h"
+
+namespace Chess
+{
+	// Seed of the random games in the tests and the evaluation bench, every run plays the same games
+	static constexpr uint32_t randomGamesSeed = 12345;
+
+	// Point of a random game the visitor is called at
+	enum class RandomGameEvent
+	{
+		Start,		// once, before the first game
+		Node,		// before a move is chosen, the legal moves are generated
+		Played,		// after the chosen move was made
+		Unmade		// after a move was taken back, every game is taken back to the starting position
+	};
+
+	// Plays games random games of up to plies moves from the board's position. The visitor is called with
+	// every event and returns false to stop, the board is back at its position either way.
+	// Returns false if the visitor stopped the games
+	template <typename Visitor>
+	bool playRandomGames(ChessBoard& board, int games, int plies, std::mt19937& random, Visitor&& visit)
+	{
+		bool passed = visit(RandomGameEvent::Start);
+
+		for (int game = 0; game < games && passed; game++)
+		{
+			int played = 0;
+
+			for (; played < plies && passed; played++)
+			{
+				board.generateMoves();
+				size_t movesSize = board.getMovesSize();
+
+				if (movesSize == 0 || board.getGameState().isGameOver())
+				{
+					break;
+				}
+
+				// the visitor may search the node and overwrite the generated moves
+				std::array<Move, Consts::MaxPossibleMoves> legalMoves = board.getLegalMoves();
+
+				if (!visit(RandomGameEvent::Node))
+				{
+					passed = false;
+					break;
+				}
+
+				board.makeMove(legalMoves[random() % movesSize]);
+				passed = visit(RandomGameEvent::Played);
+			}
+
+			for (; played > 0; played--)
+			{
+				board.unmakeMove();
+				passed = passed && visit(RandomGameEvent::Unmade);
+			}
+		}
+
+		return passed;
+	}
+}
@@ -15,7 +15,7 @@ namespace Chess
 
 	public:
 		// starting position, FEN: rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1
-		static constexpr uint64_t startingPosition = 15346820377121847993;
+		static constexpr uint64_t startingPosition = 15346820377121847993ULL;
 
 		// Set of seeded random numbers are generated for each piece, its color and its position
 		static std::array<std::array<uint64_t, 64>, Consts::TotalBitboards> piecesArray;
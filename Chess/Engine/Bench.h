@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Chess::Bench
+{
+	struct BenchResult
+	{
+		uint64_t nodes;		// functional signature, changes whenever search or evaluation behave differently
+		std::chrono::milliseconds time;
+		uint64_t nodesPerSecond;
+	};
+
+	struct EvalBenchResult
+	{
+		uint64_t evaluations;			// per kernel version
+		uint64_t evalsPerSecond;		// SIMD kernels
+		uint64_t scalarEvalsPerSecond;	// portable kernels
+		bool consistent;				// both gave the same score for every position
+	};
+
+	constexpr int defaultDepth = 7;
+	constexpr int defaultEvalPlies = 200;
+
+	extern const std::vector<std::string> defaultPositions;
+
+	// Searches every position to a fixed depth with a single fresh search, positions share the tables
+	// like in a game, so the node count only depends on the code and the list of positions
+	BenchResult run(const std::vector<std::string>& fens, int depth, std::ostream& out);
+
+	// Evaluates the positions of a random game (fixed seed) of up to plies moves from every fen, once with the
+	// SIMD and once with the scalar evaluation kernels. Every position is evaluated several times in a row,
+	// so making the moves does not dominate the time
+	EvalBenchResult runEval(const std::vector<std::string>& fens, int plies, std::ostream& out);
+}
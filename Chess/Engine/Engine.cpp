@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "Engine.h"
+
+namespace Chess
+{
+	Engine::Engine() :
+		search{ std::make_unique<Search>() }
+	{
+	}
+
+	Engine::~Engine()
+	{
+		stop();
+	}
+
+	bool Engine::setPosition(const std::string& fen, const std::vector<std::string>& moves)
+	{
+		board = ChessBoard();
+
+		try
+		{
+			board.loadPosFromFen(fen);
+		}
+		catch (const std::invalid_argument&)
+		{
+			board = ChessBoard();
+			return false;
+		}
+
+		for (const std::string& moveString : moves)
+		{
+			Move move = parseMove(moveString);
+
+			if (move.isNullMove())
+			{
+				board = ChessBoard();
+				return false;
+			}
+
+			board.makeMove(move);
+			board.generateMoves();
+		}
+
+		return true;
+	}
+
+	Move Engine::parseMove(const std::string& moveString)
+	{
+		board.generateMoves();
+		std::vector<Move> legalMoves = board.getLegalMovesAsVector();
+
+		auto it = std::find_if(legalMoves.begin(), legalMoves.end(),
+			[&moveString](const Move& move) { return ChessBoard::toChessNotation(move) == moveString; });
+
+		// only queen promotions are generated, underpromotions are played as a queen
+		if (it == legalMoves.end() && moveString.size() == 5)
+		{
+			it = std::find_if(legalMoves.begin(), legalMoves.end(),
+				[&moveString](const Move& move) { return move.isPromotion() && ChessBoard::toChessNotation(move).substr(0, 4) == moveString.substr(0, 4); });
+		}
+
+		return it != legalMoves.end() ? *it : Move{ 0, 0 };
+	}
+
+	void Engine::go(const SearchLimits& limits)
+	{
+		stop();
+
+		// book moves are played instantly, but a ponder or infinite search has to wait for stop
+		if (ownBook && book && !limits.ponder && !limits.infinite)
+		{
+			Move bookMove = book->getWeightedBookMove(board.getZobristKey());
+
+			if (!bookMove.isNullMove())
+			{
+				if (bestMoveCallback)
+				{
+					bestMoveCallback(bookMove, Move{ 0, 0 });
+				}
+
+				return;
+			}
+		}
+
+		if (limits.moveTime.count() > 0)
+		{
+			search->setMoveTime(limits.moveTime);
+		}
+		else if (limits.timeLeft.count() > 0)
+		{
+			search->setTimeLimits(limits.timeLeft, limits.increment, limits.movesToGo);
+		}
+
+		search->setDepthLimit(limits.depth);
+		search->setNodeLimit(limits.nodes);
+
+		// an infinite search is a ponder search that is never hit, both only return after stop
+		if (limits.ponder || limits.infinite)
+		{
+			search->startPondering();
+		}
+
+		searchThread = std::jthread([this, board = board](std::stop_token stopToken) mutable
+			{
+				Move bestMove = search->searchBestMove(board, stopToken);
+				Move ponderMove = Move{ 0, 0 };
+
+				// expected reply is the second move of the principal variation
+				SearchInfo info = search->getSearchInfo();
+				if (!info.lines.empty() && info.lines[0].moves.size() > 1 && info.lines[0].moves[0] == bestMove)
+				{
+					ponderMove = info.lines[0].moves[1];
+				}
+
+				if (bestMoveCallback)
+				{
+					bestMoveCallback(bestMove, ponderMove);
+				}
+			});
+	}
+
+	void Engine::stop()
+	{
+		if (searchThread.joinable())
+		{
+			searchThread.request_stop();
+			searchThread.join();
+		}
+	}
+
+	void Engine::ponderHit()
+	{
+		search->ponderHit();
+	}
+
+	void Engine::newGame()
+	{
+		stop();
+		search->clearHistory();
+	}
+
+	void Engine::setHashSize(int megabytes)
+	{
+		stop();
+		search->setHashSize(megabytes);
+	}
+
+	void Engine::setMultiPV(int lines)
+	{
+		stop();
+		search->setMultiPV(lines);
+	}
+
+	void Engine::setOwnBook(bool enabled)
+	{
+		ownBook = enabled;
+
+		// loaded on first use, so startup does not read the book
+		if (ownBook && !book)
+		{
+			book = std::make_unique<Book>(Book::loadFromBook(MASTER_BOOK_PATH, maxBookPlyCount));
+		}
+	}
+
+	bool Engine::setEvalFile(const std::string& fileName)
+	{
+		stop();
+
+		if (fileName.empty())
+		{
+			search->setNetwork(nullptr);
+			network.reset();
+			return true;
+		}
+
+		std::unique_ptr<Nnue::Network> loaded = Nnue::Network::load(fileName);
+
+		if (!loaded)
+		{
+			return false;
+		}
+
+		// the search drops its pointer to the old network before it is freed
+		search->setNetwork(loaded.get());
+		network = std::move(loaded);
+		return true;
+	}
+}
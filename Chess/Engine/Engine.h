@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "Book.h"
+#include "Search.h"
+
+namespace Chess
+{
+	// Limits of a single search, 0 means no limit
+	struct SearchLimits
+	{
+		int depth = 0;
+		uint64_t nodes = 0;
+		std::chrono::milliseconds moveTime{ 0 };
+
+		// clock of the side to move, movesToGo = 0 means sudden death
+		std::chrono::milliseconds timeLeft{ 0 };
+		std::chrono::milliseconds increment{ 0 };
+		int movesToGo = 0;
+
+		bool ponder = false;	// search on the opponent's time until ponderHit or stop
+		bool infinite = false;	// search until stop
+	};
+
+	// Called from the search thread when the search is finished, ponderMove is null if unknown
+	using BestMoveCallback = std::function<void(Move bestMove, Move ponderMove)>;
+
+	// Headless engine, owns the current position and runs the search on its own thread
+	class Engine
+	{
+		static constexpr int maxBookPlyCount = 10;
+
+		std::unique_ptr<Search> search;
+		std::jthread searchThread;
+
+		ChessBoard board;
+
+		bool ownBook = false;
+		std::unique_ptr<Book> book;
+
+		// network loaded with setEvalFile, the default one (if any) is owned by Nnue
+		std::unique_ptr<Nnue::Network> network;
+
+		BestMoveCallback bestMoveCallback;
+
+	public:
+		Engine();
+		~Engine();
+
+		// Loads the fen and plays the moves (coordinate notation), false and the starting position if anything is invalid
+		bool setPosition(const std::string& fen, const std::vector<std::string>& moves = {});
+		const ChessBoard& getBoard() const { return board; };
+
+		// Null move if the move is not legal in the current position
+		Move parseMove(const std::string& moveString);
+
+		// Starts searching the current position, the result is passed to the best move callback
+		void go(const SearchLimits& limits);
+
+		// Stops the search and waits for the best move callback
+		void stop();
+		void ponderHit();
+		void newGame();
+
+		// Options, they stop a running search
+		void setHashSize(int megabytes);
+		void setMultiPV(int lines);
+		void setOwnBook(bool enabled);
+
+		// Network file for the evaluation, an empty name selects the handcrafted evaluation.
+		// False (and the evaluation is not changed) if the file is not a valid network
+		bool setEvalFile(const std::string& fileName);
+
+		// Not thread-safe, set them before the first search
+		void setInfoCallback(SearchInfoCallback callback) { search->setInfoCallback(std::move(callback)); };
+		void setBestMoveCallback(BestMoveCallback callback) { bestMoveCallback = std::move(callback); };
+	};
+}
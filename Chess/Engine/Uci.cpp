@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <vector>
+
+#include "Uci.h"
+
+namespace Chess
+{
+	Uci::Uci(std::istream& input, std::ostream& output) :
+		input{ input },
+		output{ output }
+	{
+		// both are called from the search thread
+		engine.setInfoCallback([this](const SearchInfo& info) { sendInfo(info); });
+		engine.setBestMoveCallback([this](Move bestMove, Move ponderMove) { sendBestMove(bestMove, ponderMove); });
+	}
+
+	void Uci::loop()
+	{
+		for (std::string line; std::getline(input, line);)
+		{
+			std::istringstream command(line);
+			std::string token;
+			command >> token;
+
+			if (token == "uci") handleUci();
+			else if (token == "isready") send("readyok");
+			else if (token == "setoption") handleSetOption(command);
+			else if (token == "ucinewgame") engine.newGame();
+			else if (token == "position") handlePosition(command);
+			else if (token == "go") handleGo(command);
+			else if (token == "stop") engine.stop();
+			else if (token == "ponderhit") engine.ponderHit();
+			else if (token == "quit") break;
+			else if (!token.empty()) send("info string unknown command " + token);
+		}
+
+		engine.stop();
+	}
+
+	void Uci::handleUci()
+	{
+		send(std::string("id name ") + engineName);
+		send(std::string("id author ") + engineAuthor);
+
+		send("option name Hash type spin default " + std::to_string(Search::defaultHashSize) + " min 1 max " + std::to_string(maxHashSize));
+		// the search is single threaded
+		send("option name Threads type spin default 1 min 1 max 1");
+		send("option name MultiPV type spin default 1 min 1 max " + std::to_string(Search::maxMultiPV));
+		send("option name Ponder type check default false");
+		send("option name OwnBook type check default false");
+		send(std::string("option name EvalFile type string default ") + (Nnue::defaultNetwork() ? NNUE_PATH : "<empty>"));
+
+		send("uciok");
+	}
+
+	// setoption name <name> [value <value>]
+	void Uci::handleSetOption(std::istringstream& command)
+	{
+		std::string token, name, value;
+
+		command >> token;
+		while (command >> token && token != "value")
+		{
+			name += name.empty() ? token : " " + token;
+		}
+
+		// the value is the rest of the line, file names may contain spaces
+		std::getline(command >> std::ws, value);
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+
+		int number = 0;
+		bool numeric = name == "Hash" || name == "MultiPV" || name == "Threads";
+
+		// a typo in the GUI leaves the option unchanged
+		if (numeric && !parseInt(value, number))
+		{
+			send("info string invalid value for " + name);
+		}
+		else if (name == "Hash")
+		{
+			engine.setHashSize(std::clamp(number, 1, maxHashSize));
+		}
+		else if (name == "MultiPV")
+		{
+			engine.setMultiPV(number);
+		}
+		else if (name == "OwnBook")
+		{
+			engine.setOwnBook(value == "true");
+		}
+		else if (name == "EvalFile")
+		{
+			std::string fileName = value == "<empty>" ? "" : value;
+
+			if (!engine.setEvalFile(fileName))
+			{
+				send("info string cannot load network " + fileName + ", evaluation unchanged");
+			}
+		}
+		else if (name != "Threads" && name != "Ponder")
+		{
+			send("info string unknown option " + name);
+		}
+	}
+
+	// position [startpos | fen <fen>] [moves <move1> ... <moveN>]
+	void Uci::handlePosition(std::istringstream& command)
+	{
+		std::string token, fen;
+		std::vector<std::string> moves;
+
+		command >> token;
+		if (token == "startpos")
+		{
+			fen = Consts::startFen;
+			command >> token;
+		}
+		else if (token == "fen")
+		{
+			while (command >> token && token != "moves")
+			{
+				fen += fen.empty() ? token : " " + token;
+			}
+		}
+		else
+		{
+			return;
+		}
+
+		while (command >> token)
+		{
+			moves.push_back(token);
+		}
+
+		if (!engine.setPosition(fen, moves))
+		{
+			send("info string invalid position " + fen);
+		}
+	}
+
+	// go [ponder] [infinite] [depth x] [nodes x] [movetime x] [wtime x] [btime x] [winc x] [binc x] [movestogo x]
+	void Uci::handleGo(std::istringstream& command)
+	{
+		SearchLimits limits;
+		bool white = engine.getBoard().isWhiteToMove();
+
+		for (std::string token; command >> token;)
+		{
+			if (token == "ponder") limits.ponder = true;
+			else if (token == "infinite") limits.infinite = true;
+			else if (token == "depth") command >> limits.depth;
+			else if (token == "nodes") command >> limits.nodes;
+			else if (token == "movestogo") command >> limits.movesToGo;
+			else
+			{
+				long long value = 0;
+				command >> value;
+
+				if (token == "movetime") limits.moveTime = std::chrono::milliseconds(value);
+				else if (token == (white ? "wtime" : "btime")) limits.timeLeft = std::chrono::milliseconds(value);
+				else if (token == (white ? "winc" : "binc")) limits.increment = std::chrono::milliseconds(value);
+			}
+		}
+
+		engine.go(limits);
+	}
+
+	void Uci::sendInfo(const SearchInfo& info)
+	{
+		auto time = std::max<long long>(info.elapsed.count(), 0);
+
+		for (size_t i = 0; i < info.lines.size(); i++)
+		{
+			std::string message = "info depth " + std::to_string(info.stats.depth);
+
+			if (info.lines.size() > 1)
+			{
+				message += " multipv " + std::to_string(i + 1);
+			}
+
+			message += " score " + scoreToString(info.lines[i]);
+			message += " nodes " + std::to_string(info.stats.nodesVisited);
+			message += " nps " + std::to_string(info.stats.nodesPerSecond);
+			message += " hashfull " + std::to_string(info.hashFull);
+			message += " time " + std::to_string(time);
+			message += " pv";
+
+			for (const Move& move : info.lines[i].moves)
+			{
+				message += " " + moveToString(move);
+			}
+
+			send(message);
+		}
+	}
+
+	void Uci::sendBestMove(Move bestMove, Move ponderMove)
+	{
+		std::string message = "bestmove " + moveToString(bestMove);
+
+		if (!bestMove.isNullMove() && !ponderMove.isNullMove())
+		{
+			message += " ponder " + moveToString(ponderMove);
+		}
+
+		send(message);
+	}
+
+	void Uci::send(const std::string& message)
+	{
+		std::lock_guard<std::mutex> lock(outputMutex);
+		output << message << std::endl;
+	}
+
+	bool Uci::parseInt(const std::string& value, int& result)
+	{
+		const char* end = value.data() + value.size();
+		auto [last, error] = std::from_chars(value.data(), end, result);
+
+		return error == std::errc() && last == end;
+	}
+
+	// null move (no legal moves) is 0000 in UCI
+	std::string Uci::moveToString(Move move)
+	{
+		return move.isNullMove() ? "0000" : ChessBoard::toChessNotation(move);
+	}
+
+	// mate scores count plies from the root, UCI counts moves
+	std::string Uci::scoreToString(const SearchLine& line)
+	{
+		if (std::abs(line.evaluation) < Search::mateScoreThreshold)
+		{
+			return "cp " + std::to_string(line.evaluation);
+		}
+
+		int moves = (Search::mateScore - std::abs(line.evaluation) + 1) / 2;
+		return "mate " + std::to_string(line.evaluation > 0 ? moves : -moves);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "Engine.h"
+
+namespace Chess
+{
+	// Universal Chess Interface, reads commands from the input and answers on the output.
+	// The engine searches on its own thread, so stop and ponderhit are handled while searching
+	class Uci
+	{
+		static constexpr const char* engineName = "chess-engine";
+		static constexpr const char* engineAuthor = "Andrew Malokhatko";
+
+		static constexpr int maxHashSize = 4096;
+
+		std::istream& input;
+		std::ostream& output;
+		std::mutex outputMutex;
+
+		Engine engine;
+
+	public:
+		Uci(std::istream& input, std::ostream& output);
+
+		// Runs until quit or the end of the input
+		void loop();
+
+	private:
+		void handleUci();
+		void handleSetOption(std::istringstream& command);
+		void handlePosition(std::istringstream& command);
+		void handleGo(std::istringstream& command);
+
+		void sendInfo(const SearchInfo& info);
+		void sendBestMove(Move bestMove, Move ponderMove);
+		void send(const std::string& message);
+
+		// Whole value as an integer, false for an empty, non-numeric or out of range value
+		static bool parseInt(const std::string& value, int& result);
+
+		static std::string moveToString(Move move);
+		static std::string scoreToString(const SearchLine& line);
+	};
+}
@@ -1,6 +1,5 @@
 #include "GameManager.h"
 #include "Zobrist.h"
-#include "Tests.h"
 
 
 namespace Chess
@@ -8,45 +7,71 @@ namespace Chess
 	GameManager::GameManager(GameMode gameMode, TimeControl timeControl) :
 		gameMode {gameMode},
 		timeControl{timeControl},
-		lastUpdate{ std::chrono::high_resolution_clock::now()},
+		lastUpdate{ std::chrono::steady_clock::now()},
 		timeWhite{ std::chrono::milliseconds(static_cast<int>(timeControl))},
 		timeBlack{ std::chrono::milliseconds(static_cast<int>(timeControl))}
 	{
 		computer.setTimeLeft(std::chrono::milliseconds(static_cast<int>(timeControl)));
+		computer.setInfoCallback([this](const SearchInfo& info) { onSearchInfo(info); });
 		Zobrist();
 	}
 
 	GameManager::GameManager(void) :
 		gameMode {static_cast<int>(GameMode::Human)},
 		timeControl{static_cast<int>(TimeControl::Blitz)},
-		lastUpdate{ std::chrono::high_resolution_clock::now()},
+		lastUpdate{ std::chrono::steady_clock::now()},
 		timeWhite{ std::chrono::milliseconds(static_cast<int>(timeControl)) },
 		timeBlack{ std::chrono::milliseconds(static_cast<int>(timeControl)) }
 	{
 		computer.setTimeLeft(std::chrono::milliseconds(static_cast<int>(timeControl)));
+		computer.setInfoCallback([this](const SearchInfo& info) { onSearchInfo(info); });
 		Zobrist();
 	}
 
 	void GameManager::update()
 	{
+		// analyze the current position until it changes, clocks do not run
+		if (gameMode == GameMode::Analysis)
+		{
+			if (!calculating && !chessBoard.getGameState().isGameOver())
+			{
+				calculating = true;
+				ChessBoard boardCopy = chessBoard.shallowCopy();
+				computerCalculations = std::jthread([this, boardCopy](std::stop_token stopToken) { computerAnalyze(stopToken, boardCopy); });
+			}
+
+			return;
+		}
+
 		if (chessBoard.getGameState().isGameOver() || !gameInProgress) return;
 
 		// make computer move is not player to move and we are not currently calculating
 		if (gameMode == GameMode::Computer && !playerToMove && !calculating)
 		{
 			calculating = true;
-			computerCalculations = std::jthread(&GameManager::computerMakeMove, this);
+			computer.setTimeLeft(computerWhite ? timeWhite : timeBlack);
+			//copy board and pass it to the computer
+			ChessBoard boardCopy = chessBoard.shallowCopy();
+			computerCalculations = std::jthread([this, boardCopy](std::stop_token stopToken) { computerMakeMove(stopToken, boardCopy); });
+		}
+		// the computer's clock does not run while pondering, so the limits are already known
+		else if (gameMode == GameMode::Computer && playerToMove && !calculating && ponderEnabled && !ponderMove.isNullMove())
+		{
+			calculating = true;
+			pondering = true;
+			computer.setTimeLeft(computerWhite ? timeWhite : timeBlack);
+			computer.startPondering();
+
+			// ponder on the position after the expected reply, the search only returns after a ponder hit or stop
+			ChessBoard boardCopy = chessBoard.shallowCopy();
+			boardCopy.makeMove(ponderMove);
+			computerCalculations = std::jthread([this, boardCopy](std::stop_token stopToken) { computerMakeMove(stopToken, boardCopy); });
 		}
 
-		std::chrono::time_point curTime = std::chrono::high_resolution_clock::now();
+		std::chrono::time_point curTime = std::chrono::steady_clock::now();
 		auto timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(curTime - lastUpdate);
 		lastUpdate = curTime;
 
-		if (chessBoard.isWhiteToMove() == computerWhite)
-		{
-			computer.updateTime(timeSinceLastUpdate);
-		}
-
 		if (chessBoard.isWhiteToMove())
 		{
 			timeWhite -= timeSinceLastUpdate;
@@ -67,33 +92,90 @@ namespace Chess
 		}
 	}
 
-	void GameManager::computerMakeMove()
+	void GameManager::computerMakeMove(std::stop_token stopToken, ChessBoard board)
 	{
-		//copy board and pass it to the computer
-		ChessBoard boardCopy = chessBoard.shallowCopy();
-		Move response = computer.getBestMove(boardCopy);
+		Move response = computer.getBestMove(board, stopToken);
 
 		if (!discardSearchResult)
 		{
+			// the ui thread reads ponderMove as soon as the player is allowed to move
+			ponderMove = computer.getPonderMove();
 			makeMove(response);
 			playerToMove = true;
 		}
 
-		positionEvaluation = (float)computer.getEvaluation() / 100;
-
 		// set calculating to false when finished
 		// + do not discard search result on the next calculation
 		discardSearchResult = false;
+		pondering = false;
 		calculating = false;
 	} 
 
+	void GameManager::computerAnalyze(std::stop_token stopToken, ChessBoard board)
+	{
+		computer.analyze(board, stopToken);
+
+		discardSearchResult = false;
+		calculating = false;
+	}
+
+	void GameManager::onSearchInfo(const SearchInfo& info)
+	{
+		// the ponder search belongs to a position that was not played yet
+		if (pondering || info.lines.empty())
+		{
+			return;
+		}
+
+		int evaluation = info.whiteToMove ? info.lines[0].evaluation : -info.lines[0].evaluation;
+		positionEvaluation = (float)evaluation / 100;
+	}
+
+	void GameManager::stopComputer()
+	{
+		if (calculating)
+		{
+			discardSearchResult = true;
+			computerCalculations.request_stop();
+		}
+
+		if (computerCalculations.joinable())
+		{
+			computerCalculations.join();
+		}
+	}
+
 	void GameManager::processMove(Move move)
 	{
-		// Ignore playerToMove, if human plays
-		if (gameMode == GameMode::Human || playerToMove)
+		// Ignore playerToMove, if human plays or analyzes
+		if (gameMode == GameMode::Human || gameMode == GameMode::Analysis || playerToMove)
 		{
+			// restart the analysis from the new position
+			if (gameMode == GameMode::Analysis)
+			{
+				stopComputer();
+			}
+
 			makeMove(move);
 			playerToMove = false;
+
+			Move expectedMove = ponderMove;
+			ponderMove = Move{ 0, 0 };
+
+			if (pondering)
+			{
+				// ponder hit, the running search becomes the real one and keeps its tables and depth
+				if (move == expectedMove && gameInProgress)
+				{
+					pondering = false;
+					computer.ponderHit();
+				}
+				// ponder miss, throw the search away and let update start a new one
+				else
+				{
+					stopComputer();
+				}
+			}
 		}
 	}
 
@@ -159,6 +241,16 @@ namespace Chess
 		startNewGame();
 	}
 
+	void GameManager::setMultiPV(int lines)
+	{
+		computer.setMultiPV(lines);
+	}
+
+	void GameManager::setPonder(bool ponder)
+	{
+		ponderEnabled = ponder;
+	}
+
 	void GameManager::setTimeControl(TimeControl newTimeControl)
 	{
 		timeControl = newTimeControl;
@@ -169,6 +261,10 @@ namespace Chess
 
 	void GameManager::startNewGame()
 	{
+		stopComputer();
+		ponderMove = Move{ 0, 0 };
+		positionEvaluation = 0.0f;
+
 		chessBoard.reset();
 		computer.reset();
 
@@ -183,14 +279,14 @@ namespace Chess
 		timeWhite = std::chrono::milliseconds(static_cast<int>(timeControl));
 		timeBlack = std::chrono::milliseconds(static_cast<int>(timeControl));
 
-		lastUpdate = std::chrono::high_resolution_clock::now();
+		lastUpdate = std::chrono::steady_clock::now();
 	}
 
 	void GameManager::runGame()
 	{
 		gameInProgress = true;
 
-		lastUpdate = std::chrono::high_resolution_clock::now();
+		lastUpdate = std::chrono::steady_clock::now();
 	}
 
 	void GameManager::makeMove(Move move)
@@ -211,26 +307,28 @@ namespace Chess
 			return;
 		}
 
+		stopComputer();
+		ponderMove = Move{ 0, 0 };
+
 		chessBoard.unmakeMove();
 		chessBoard.generateMoves();
 
 		playerToMove = !playerToMove;
-
-		if (calculating)
-		{
-			computer.forceStopSearch();
-			discardSearchResult = true;
-		}
 	}
 
-	void GameManager::runTests() const
+	float GameManager::getEvaluation() const
 	{
-		Test::testMoveGeneration(Test::testGithub);
-		Test::testMoveGeneration(Test::testDefault);
+		return positionEvaluation;
 	}
 
-	float GameManager::getEvaluation() const
+	// lines of the running search, they do not belong to the position once the computer has moved
+	std::vector<SearchLine> GameManager::getSearchLines() const
 	{
-		return positionEvaluation;
+		if (!calculating || pondering)
+		{
+			return {};
+		}
+
+		return computer.getSearchInfo().lines;
 	}
 }
\ No newline at end of file
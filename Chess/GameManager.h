@@ -5,6 +5,7 @@
 #include "Debug.h"
 
 #include <array>
+#include <atomic>
 #include <vector>
 #include <chrono>
 #include <thread>
@@ -25,6 +26,7 @@ namespace Chess
 	{
 		Computer,
 		Human,
+		Analysis,
 	};
 
 	enum class TimeControl
@@ -37,14 +39,22 @@ namespace Chess
 	class GameManager
 	{
 	private:
-		bool playerToMove = true;
+		// published last by the search thread, everything it wrote before is visible to the ui thread
+		std::atomic<bool> playerToMove = true;
 		bool computerWhite = false;
-		bool discardSearchResult = false;
+		std::atomic<bool> discardSearchResult = false;
+
+		std::atomic<bool> calculating = false;
+
+		// search the expected reply on the opponent's time
+		bool ponderEnabled = true;
+		std::atomic<bool> pondering = false;
+		Move ponderMove = Move{ 0, 0 };
 
-		bool calculating = false;
 		bool gameInProgress = false;
 
-		float positionEvaluation = 0.0f;
+		// white's perspective, updated by the search thread after every depth
+		std::atomic<float> positionEvaluation = 0.0f;
 
 		ChessBoard chessBoard;
 		AI computer;
@@ -62,7 +72,10 @@ namespace Chess
 
 	private:
 		void makeMove(Move move);
-		void computerMakeMove();
+		void computerMakeMove(std::stop_token stopToken, ChessBoard board);
+		void computerAnalyze(std::stop_token stopToken, ChessBoard board);
+		void onSearchInfo(const SearchInfo& info);
+		void stopComputer();
 
 	public:
 		GameManager(void);
@@ -80,15 +93,14 @@ namespace Chess
 		GameData getGameData() const;
 		DebugData getDebugData() const;
 		float getEvaluation() const;
+		std::vector<SearchLine> getSearchLines() const;
 
 		// Setters
 		void loadPositionFromFEN(const std::string FEN);
 		void setGameMode(GameMode gameMode);
 		void setComputerWhite(bool white);
 		void setTimeControl(TimeControl timeControl);
-
-		
-		// Tests
-		void runTests() const;
+		void setMultiPV(int lines);
+		void setPonder(bool ponder);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,506 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "Tuner.h"
+#include "PawnHash.h"
+
+namespace Chess::Tuning
+{
+	namespace
+	{
+		// lines are resolved in chunks, so the data set is never in memory as text
+		constexpr size_t chunkSize = 1 << 18;
+		constexpr int maxResolvePly = 16;
+
+		// calls work(begin, end, thread) for equal slices of [0, size), one thread each
+		template <typename Work>
+		void parallelFor(size_t size, int threads, const Work& work)
+		{
+			std::vector<std::jthread> workers;
+			size_t slice = (size + threads - 1) / threads;
+
+			for (int thread = 0; thread < threads; thread++)
+			{
+				size_t begin = thread * slice;
+				size_t end = std::min(size, begin + slice);
+
+				if (begin >= end)
+				{
+					break;
+				}
+
+				workers.emplace_back(work, begin, end, thread);
+			}
+		}
+
+		// Quiescence search over captures with the engine's evaluation, pv gets the moves to the quiet leaf
+		int resolve(ChessBoard& board, PawnHashTable& pawnHash, int alpha, int beta, int ply, std::vector<Move>& pv)
+		{
+			pv.clear();
+
+			int standPat = Evaluation::EvaluatePosition(board, pawnHash);
+
+			if (board.getGameState().isGameOver() || ply >= maxResolvePly || standPat >= beta)
+			{
+				return standPat;
+			}
+
+			alpha = std::max(alpha, standPat);
+
+			board.generateMoves(false);
+			std::array<Move, Consts::MaxPossibleMoves> moves = board.getLegalMoves();
+			size_t movesSize = board.getMovesSize();
+
+			// most valuable victim first
+			std::sort(moves.begin(), moves.begin() + movesSize, [&](const Move& a, const Move& b)
+				{
+					return Evaluation::pieceValues[board.getPieceType(a.to) & ~Piece::Black] > Evaluation::pieceValues[board.getPieceType(b.to) & ~Piece::Black];
+				});
+
+			std::vector<Move> childPv;
+
+			for (size_t i = 0; i < movesSize; i++)
+			{
+				board.makeMove(moves[i]);
+				int score = -resolve(board, pawnHash, -beta, -alpha, ply + 1, childPv);
+				board.unmakeMove();
+
+				if (score > alpha)
+				{
+					alpha = score;
+
+					pv.assign(1, moves[i]);
+					pv.insert(pv.end(), childPv.begin(), childPv.end());
+
+					if (alpha >= beta)
+					{
+						break;
+					}
+				}
+			}
+
+			return alpha;
+		}
+
+		double sigmoid(double K, double evaluation)
+		{
+			return 1.0 / (1.0 + std::pow(10.0, -K * evaluation / 400.0));
+		}
+	}
+
+	Tuner::Tuner(int threads) :
+		threads{ std::max(threads, 1) },
+		weights(2 * Evaluation::ParameterCount)
+	{
+		for (int i = 0; i < Evaluation::ParameterCount; i++)
+		{
+			weights[i] = Evaluation::mgValue(Evaluation::evaluationWeights[i]);
+			weights[Evaluation::ParameterCount + i] = Evaluation::egValue(Evaluation::evaluationWeights[i]);
+		}
+	}
+
+	double Tuner::parseResult(const std::string& line)
+	{
+		// the results are looked for after the 4 fields every fen has
+		size_t start = 0;
+		for (int field = 0; field < 4 && start != std::string::npos; field++)
+		{
+			start = line.find(' ', start + 1);
+		}
+
+		if (start == std::string::npos)
+		{
+			return -1.0;
+		}
+
+		std::string labels = line.substr(start);
+		double result = -1.0;
+
+		try
+		{
+			if (size_t bracket = labels.find('['); bracket != std::string::npos)
+			{
+				result = std::stod(labels.substr(bracket + 1));
+			}
+			else if (size_t separator = labels.rfind('|'); separator != std::string::npos)
+			{
+				result = std::stod(labels.substr(separator + 1));
+			}
+			else if (labels.contains("1/2-1/2"))
+			{
+				result = 0.5;
+			}
+			else if (labels.contains("1-0"))
+			{
+				result = 1.0;
+			}
+			else if (labels.contains("0-1"))
+			{
+				result = 0.0;
+			}
+		}
+		catch (const std::exception&)
+		{
+			return -1.0;
+		}
+
+		return (result >= 0.0 && result <= 1.0) ? result : -1.0;
+	}
+
+	size_t Tuner::load(const std::string& fileName, std::ostream& out)
+	{
+		std::ifstream file(fileName);
+		if (!file)
+		{
+			out << "Could not open " << fileName << std::endl;
+			return 0;
+		}
+
+		size_t added = 0;
+		size_t lines = 0;
+		std::vector<std::string> chunk;
+
+		auto resolveChunk = [&]()
+		{
+			std::vector<std::vector<Position>> threadPositions(threads);
+			std::vector<std::vector<Coefficient>> threadCoefficients(threads);
+
+			parallelFor(chunk.size(), threads, [&](size_t begin, size_t end, int thread)
+				{
+					std::optional<ChessBoard> board;
+					auto pawnHash = std::make_unique<PawnHashTable>();
+					std::vector<Move> pv;
+
+					for (size_t i = begin; i < end; i++)
+					{
+						double result = parseResult(chunk[i]);
+						if (result < 0.0)
+						{
+							continue;
+						}
+
+						try
+						{
+							board.emplace();
+							board->loadPosFromFen(chunk[i]);
+						}
+						catch (const std::invalid_argument&)
+						{
+							continue;
+						}
+
+						if (board->getGameState().isGameOver())
+						{
+							continue;
+						}
+
+						resolve(*board, *pawnHash, Evaluation::NegInfinity, Evaluation::PosInfinity, 0, pv);
+
+						for (const Move& move : pv)
+						{
+							board->makeMove(move);
+						}
+
+						// captures can end the game with insufficient material
+						if (board->getGameState().isGameOver())
+						{
+							continue;
+						}
+
+						Evaluation::Trace trace = Evaluation::traceEvaluation(*board);
+
+						// specialized and scaled endgames are not linear in the weights
+						if (trace.specialized || trace.scale != Endgames::normalScale)
+						{
+							continue;
+						}
+
+						Position position{};
+						position.firstCoefficient = static_cast<uint32_t>(threadCoefficients[thread].size());
+						position.gamePhase = static_cast<uint8_t>(trace.gamePhase);
+						position.result = static_cast<float>(result);
+						position.mgBase = trace.mgBase;
+						position.egBase = trace.egBase;
+
+						for (int parameter = 0; parameter < Evaluation::ParameterCount; parameter++)
+						{
+							if (trace.coefficients[parameter] != 0)
+							{
+								threadCoefficients[thread].push_back(Coefficient{ static_cast<uint8_t>(parameter), static_cast<int16_t>(trace.coefficients[parameter]) });
+								position.coefficientCount++;
+							}
+						}
+
+						threadPositions[thread].push_back(position);
+					}
+				});
+
+			// coefficients of every thread are appended, so their positions are shifted
+			for (int thread = 0; thread < threads; thread++)
+			{
+				uint32_t offset = static_cast<uint32_t>(coefficients.size());
+
+				for (Position& position : threadPositions[thread])
+				{
+					position.firstCoefficient += offset;
+					positions.push_back(position);
+				}
+
+				coefficients.insert(coefficients.end(), threadCoefficients[thread].begin(), threadCoefficients[thread].end());
+				added += threadPositions[thread].size();
+			}
+
+			lines += chunk.size();
+			chunk.clear();
+
+			out << "Loaded " << added << " positions from " << lines << " lines" << std::endl;
+		};
+
+		for (std::string line; std::getline(file, line);)
+		{
+			if (!line.empty())
+			{
+				chunk.push_back(std::move(line));
+			}
+
+			if (chunk.size() == chunkSize)
+			{
+				resolveChunk();
+			}
+		}
+
+		if (!chunk.empty())
+		{
+			resolveChunk();
+		}
+
+		return added;
+	}
+
+	double Tuner::evaluate(const Position& position) const
+	{
+		double material = 0.0;
+		double mg = position.mgBase;
+		double eg = position.egBase;
+
+		for (uint32_t i = position.firstCoefficient; i < position.firstCoefficient + position.coefficientCount; i++)
+		{
+			const Coefficient& coefficient = coefficients[i];
+
+			if (coefficient.parameter < Evaluation::materialParameters)
+			{
+				material += coefficient.value * weights[coefficient.parameter];
+			}
+			else
+			{
+				mg += coefficient.value * weights[coefficient.parameter];
+				eg += coefficient.value * weights[Evaluation::ParameterCount + coefficient.parameter];
+			}
+		}
+
+		return material + (mg * position.gamePhase + eg * (Evaluation::maxGamePhase - position.gamePhase)) / Evaluation::maxGamePhase;
+	}
+
+	double Tuner::loss() const
+	{
+		std::vector<double> threadLoss(threads);
+
+		parallelFor(positions.size(), threads, [&](size_t begin, size_t end, int thread)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					double error = positions[i].result - sigmoid(K, evaluate(positions[i]));
+					threadLoss[thread] += error * error;
+				}
+			});
+
+		double sum = 0.0;
+		for (double value : threadLoss)
+		{
+			sum += value;
+		}
+
+		return sum / std::max<size_t>(positions.size(), 1);
+	}
+
+	double Tuner::fitK()
+	{
+		// the loss has a single minimum in K, ternary search
+		double low = 0.0;
+		double high = 10.0;
+
+		for (int i = 0; i < 60; i++)
+		{
+			double third = (high - low) / 3.0;
+
+			K = low + third;
+			double lowLoss = loss();
+
+			K = high - third;
+			double highLoss = loss();
+
+			if (lowLoss < highLoss)
+			{
+				high -= third;
+			}
+			else
+			{
+				low += third;
+			}
+		}
+
+		K = (low + high) / 2.0;
+		return K;
+	}
+
+	double Tuner::computeGradient(std::vector<double>& gradient) const
+	{
+		const size_t size = weights.size();
+		const double scale = K * std::numbers::ln10 / 400.0;
+
+		std::vector<std::vector<double>> threadGradients(threads, std::vector<double>(size));
+		std::vector<double> threadLoss(threads);
+
+		parallelFor(positions.size(), threads, [&](size_t begin, size_t end, int thread)
+			{
+				std::vector<double>& threadGradient = threadGradients[thread];
+
+				for (size_t i = begin; i < end; i++)
+				{
+					const Position& position = positions[i];
+
+					double probability = sigmoid(K, evaluate(position));
+					double error = position.result - probability;
+					threadLoss[thread] += error * error;
+
+					// derivative of the squared error by the evaluation
+					double derivative = -2.0 * error * probability * (1.0 - probability) * scale;
+					double mgPart = derivative * position.gamePhase / Evaluation::maxGamePhase;
+					double egPart = derivative * (Evaluation::maxGamePhase - position.gamePhase) / Evaluation::maxGamePhase;
+
+					for (uint32_t j = position.firstCoefficient; j < position.firstCoefficient + position.coefficientCount; j++)
+					{
+						const Coefficient& coefficient = coefficients[j];
+
+						if (coefficient.parameter < Evaluation::materialParameters)
+						{
+							threadGradient[coefficient.parameter] += derivative * coefficient.value;
+						}
+						else
+						{
+							threadGradient[coefficient.parameter] += mgPart * coefficient.value;
+							threadGradient[Evaluation::ParameterCount + coefficient.parameter] += egPart * coefficient.value;
+						}
+					}
+				}
+			});
+
+		double count = static_cast<double>(std::max<size_t>(positions.size(), 1));
+		double sum = 0.0;
+
+		gradient.assign(size, 0.0);
+
+		for (int thread = 0; thread < threads; thread++)
+		{
+			for (size_t i = 0; i < size; i++)
+			{
+				gradient[i] += threadGradients[thread][i] / count;
+			}
+			sum += threadLoss[thread];
+		}
+
+		return sum / count;
+	}
+
+	void Tuner::optimize(int epochs, double learningRate, const std::string& headerFile, std::ostream& out)
+	{
+		constexpr double beta1 = 0.9;
+		constexpr double beta2 = 0.999;
+		constexpr double epsilon = 1e-8;
+
+		std::vector<double> gradient;
+		std::vector<double> momentum(weights.size());
+		std::vector<double> velocity(weights.size());
+
+		for (int epoch = 1; epoch <= epochs; epoch++)
+		{
+			double currentLoss = computeGradient(gradient);
+
+			double correction1 = 1.0 - std::pow(beta1, epoch);
+			double correction2 = 1.0 - std::pow(beta2, epoch);
+
+			for (size_t i = 0; i < weights.size(); i++)
+			{
+				momentum[i] = beta1 * momentum[i] + (1.0 - beta1) * gradient[i];
+				velocity[i] = beta2 * velocity[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+
+				weights[i] -= learningRate * (momentum[i] / correction1) / (std::sqrt(velocity[i] / correction2) + epsilon);
+			}
+
+			// a long run can be stopped at any time without losing everything
+			if (epoch % reportInterval == 0)
+			{
+				out << "Epoch " << epoch << " loss " << currentLoss << std::endl;
+
+				if (!writeHeader(headerFile))
+				{
+					out << "Could not write " << headerFile << std::endl;
+				}
+			}
+		}
+	}
+
+	std::array<std::array<int, 2>, Evaluation::ParameterCount> Tuner::roundedWeights() const
+	{
+		std::array<std::array<int, 2>, Evaluation::ParameterCount> rounded{};
+
+		// packed scores have 16 bits per phase
+		auto round = [](double weight) { return static_cast<int>(std::clamp(std::lround(weight), -32000L, 32000L)); };
+
+		for (int i = 0; i < Evaluation::ParameterCount; i++)
+		{
+			bool material = i < Evaluation::materialParameters;
+
+			rounded[i][0] = round(weights[i]);
+			rounded[i][1] = material ? rounded[i][0] : round(weights[Evaluation::ParameterCount + i]);
+		}
+
+		return rounded;
+	}
+
+	std::string Tuner::generateHeader() const
+	{
+		std::ostringstream header;
+
+		header << "#pragma once\n\n";
+		header << "// Generated by chess-tune, regenerate it instead of editing by hand.\n";
+		header << "// Midgame and endgame weight of every Evaluation::Parameter, in the same order\n\n";
+		header << "#include <array>\n\n";
+		header << "namespace Chess::Evaluation\n{\n";
+		header << "\tstatic constexpr std::array<std::array<int, 2>, " << Evaluation::ParameterCount << "> tunedWeights = { {\n";
+
+		std::array<std::array<int, 2>, Evaluation::ParameterCount> rounded = roundedWeights();
+
+		for (int i = 0; i < Evaluation::ParameterCount; i++)
+		{
+			header << "\t\t{ " << rounded[i][0] << ", " << rounded[i][1] << " },\t// " << Evaluation::parameterNames[i] << "\n";
+		}
+
+		header << "\t} };\n}\n";
+
+		return header.str();
+	}
+
+	bool Tuner::writeHeader(const std::string& fileName) const
+	{
+		std::ofstream file(fileName);
+		return file && (file << generateHeader());
+	}
+}
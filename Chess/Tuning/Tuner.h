@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Evaluation.h"
+
+namespace Chess::Tuning
+{
+	// Texel tuning of the evaluation weights. Positions are resolved with a quiescence search and reduced to the
+	// coefficients of their quiet leaf, the evaluation is linear in the weights, so the loss and its gradient
+	// are computed from the coefficients alone
+	class Tuner
+	{
+		// nonzero coefficient of one position
+		struct Coefficient
+		{
+			uint8_t parameter;
+			int16_t value;
+		};
+
+		struct Position
+		{
+			uint32_t firstCoefficient;
+			uint8_t coefficientCount;
+			uint8_t gamePhase;
+			float result;		// from white's point of view
+			int32_t mgBase;
+			int32_t egBase;
+		};
+
+		int threads;
+
+		std::vector<Position> positions;
+		std::vector<Coefficient> coefficients;
+
+		// midgame weight of every parameter, then endgame weight of every parameter, the material
+		// parameters only use the midgame weight
+		std::vector<double> weights;
+
+		double K = 1.0;		// scales evaluations to winning probabilities
+
+	public:
+		explicit Tuner(int threads);
+
+		// Lines are a fen followed by the result from white's point of view, as [1.0] [0.5] [0.0], 1-0 1/2-1/2 0-1
+		// (quoted or not) or a last field "| 1.0" ... Lines without a result, an invalid fen, with the game over
+		// or a specialized or scaled endgame are skipped. Returns the number of positions added
+		size_t load(const std::string& fileName, std::ostream& out);
+		size_t size() const { return positions.size(); }
+
+		// Result of a data set line, negative if it has none
+		static double parseResult(const std::string& line);
+
+		// Mean squared error between the results and the winning probabilities of the evaluations
+		double loss() const;
+
+		// Sets the scaling constant that fits the current weights best
+		double fitK();
+
+		// Adam over the whole data set for every epoch, writes the header every reportInterval epochs
+		// (the caller writes the final one)
+		void optimize(int epochs, double learningRate, const std::string& headerFile, std::ostream& out);
+
+		// Weights rounded to the engine's format
+		std::array<std::array<int, 2>, Evaluation::ParameterCount> roundedWeights() const;
+
+		// Contents of EvaluationWeights.h for the current weights
+		std::string generateHeader() const;
+		bool writeHeader(const std::string& fileName) const;
+
+	private:
+		static constexpr int reportInterval = 50;
+
+		// evaluation of a position with the current (not rounded) weights
+		double evaluate(const Position& position) const;
+
+		// loss and gradient of the mean squared error over all positions
+		double computeGradient(std::vector<double>& gradient) const;
+	};
+}
@@ -1,10 +1,19 @@
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <functional>
 #include <future>
+#include <optional>
+#include <random>
 #include <thread>
 
 #include "Tests.h"
 #include "ChessBoard.h"
+#include "Nnue.h"
+#include "RandomGames.h"
+#include "Search.h"
+#include "Tuner.h"
 
 namespace Chess::Test
 {
@@ -46,7 +55,52 @@ namespace Chess::Test
 		TestPosition {7, 178633661, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - "},
 	};
 
-	void testMoveGeneration(const std::vector<TestPosition>& positions)
+	const std::vector<SearchTestPosition> testSearch = {
+		SearchTestPosition {8, 0, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+		SearchTestPosition {30, 200000, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+		SearchTestPosition {7, 0, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+		SearchTestPosition {30, 150000, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+		SearchTestPosition {30, 100000, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+		SearchTestPosition {30, 100000, "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"},
+	};
+
+	const std::vector<MateTestPosition> testMates = {
+		MateTestPosition {1, "d1d8", "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"},
+		MateTestPosition {1, "h5f7", "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4"},
+		MateTestPosition {1, "g1g7", "7k/8/5K2/8/8/8/8/6Q1 w - - 0 1"},
+		MateTestPosition {2, "d5f6", "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 10"},
+		MateTestPosition {2, "a1a6", "kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1"},
+		MateTestPosition {3, "f8c5", "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1"},
+		MateTestPosition {3, "f6a6", "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1"}
+	};
+
+	const std::vector<EndgameTestPosition> testEndgames = {
+		EndgameTestPosition {1, "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1"},		// KPK, king in front of the pawn
+		EndgameTestPosition {1, "4k3/8/4PK2/8/8/8/8/8 w - - 0 1"},
+		EndgameTestPosition {0, "4k3/8/4PK2/8/8/8/8/8 b - - 0 1"},		// KPK, defender has the opposition
+		EndgameTestPosition {1, "7k/8/8/8/8/8/P7/K7 w - - 0 1"},		// KPK, outside of the pawn's square
+		EndgameTestPosition {0, "k7/8/8/8/8/8/P7/K7 w - - 0 1"},		// KPK, rook pawn with the king in the corner
+		EndgameTestPosition {-1, "8/8/8/8/8/2kp4/8/3K4 b - - 0 1"},
+		EndgameTestPosition {0, "8/8/8/8/8/2kp4/8/3K4 w - - 0 1"},
+		EndgameTestPosition {1, "8/8/8/8/8/8/8/KBNk4 w - - 0 1"},		// KBNK
+		EndgameTestPosition {1, "8/8/8/3k4/8/8/8/KR6 w - - 0 1"},		// KXK
+		EndgameTestPosition {-1, "8/8/8/3K4/8/8/8/kr6 w - - 0 1"},
+		EndgameTestPosition {0, "8/8/8/3k4/8/8/8/KNN5 w - - 0 1"},		// KNNK
+		EndgameTestPosition {0, "8/8/8/3k4/8/8/2b5/KR6 w - - 0 1"},		// rook against a minor piece
+		EndgameTestPosition {0, "8/8/8/3k4/8/8/2n5/KR6 w - - 0 1"},
+		EndgameTestPosition {0, "8/pp3k2/2b5/8/8/2B5/PPP2K2/8 w - - 0 1"}	// opposite-colored bishops, a pawn up
+	};
+
+	const std::vector<std::string> testPawnStructures = {
+		"4k3/8/8/3N4/8/8/8/R3K2r w - - 0 1",			// no pawns, pawn key 0
+		"2r1k3/8/8/3N4/8/8/8/2R1K2N w - - 0 1",
+		"r3k3/8/8/8/8/8/8/4K2Q b - - 0 1",
+		"4k3/8/3b4/8/8/4B3/8/R3K3 w - - 0 1",
+		"4k3/pp6/8/8/8/8/PP6/4K3 w - - 0 1",
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+	};
+
+	bool testMoveGeneration(const std::vector<TestPosition>& positions)
 	{
 		std::cout << "Starting Move Generation Test.." << std::endl << std::endl;
 
@@ -121,5 +175,379 @@ namespace Chess::Test
 
 		std::cout << std::endl << "Test finished in " << timeMs << " milliseconds" << "Calculated " << positionCount << " positions" << std::endl;
 		std::cout << success << " out of " << positions.size() << " position were calculated correctly" << std::endl;
+
+		return success == static_cast<int>(positions.size());
+	}
+
+	bool testSearchDeterminism(const std::vector<SearchTestPosition>& positions)
+	{
+		std::cout << "Starting Search Determinism Test.." << std::endl << std::endl;
+
+		int success = 0;
+
+		auto func = [](const SearchTestPosition& position, uint64_t& nodes)
+			{
+				// fresh search, so no tables are shared between the runs
+				auto search = std::make_unique<Search>();
+
+				ChessBoard board;
+				board.loadPosFromFen(position.fen);
+
+				search->setDepthLimit(position.depth);
+				search->setNodeLimit(position.nodes);
+
+				Move bestMove = search->searchBestMove(board);
+				nodes = search->getSearchStats().nodesVisited;
+
+				return bestMove;
+			};
+
+		for (const auto& position : positions)
+		{
+			uint64_t firstNodes = 0;
+			uint64_t secondNodes = 0;
+
+			Move firstMove = func(position, firstNodes);
+			Move secondMove = func(position, secondNodes);
+
+			std::string result = ChessBoard::indexToCoord(firstMove.from) + ChessBoard::indexToCoord(firstMove.to)
+				+ ", " + std::to_string(firstNodes) + " / " + std::to_string(secondNodes) + " nodes";
+
+			if (firstMove == secondMove && firstNodes == secondNodes)
+			{
+				std::cout << "\033[32mPassed:\033[0m " << position.fen << " - " << result << std::endl;
+				success++;
+			}
+			else
+			{
+				std::cout << "\033[31mError:\033[0m " << position.fen << " - " << result << std::endl;
+			}
+		}
+
+		std::cout << std::endl << success << " out of " << positions.size() << " searches were reproduced" << std::endl;
+
+		return success == static_cast<int>(positions.size());
+	}
+
+	bool testMateSearch(const std::vector<MateTestPosition>& positions)
+	{
+		std::cout << "Starting Mate Search Test.." << std::endl << std::endl;
+
+		int success = 0;
+
+		for (const auto& position : positions)
+		{
+			auto search = std::make_unique<Search>();
+
+			ChessBoard board;
+			board.loadPosFromFen(position.fen);
+
+			int matePly = 2 * position.moves - 1;
+			search->setDepthLimit(matePly);
+
+			Move bestMove = search->searchBestMove(board);
+			std::string move = ChessBoard::indexToCoord(bestMove.from) + ChessBoard::indexToCoord(bestMove.to);
+			int evaluation = search->getEvaluation();
+
+			std::string result = move + ", " + (evaluation >= Search::mateScoreThreshold ?
+				"mate at ply " + std::to_string(Search::mateScore - evaluation) : std::to_string(evaluation));
+
+			if (move == position.bestMove && evaluation == Search::mateScore - matePly)
+			{
+				std::cout << "\033[32mPassed:\033[0m " << position.fen << " - " << result << std::endl;
+				success++;
+			}
+			else
+			{
+				std::cout << "\033[31mError:\033[0m " << position.fen << " - " << result << std::endl;
+			}
+		}
+
+		std::cout << std::endl << success << " out of " << positions.size() << " mates were found" << std::endl;
+
+		return success == static_cast<int>(positions.size());
+	}
+
+	// state kept by the board for the evaluation, incremental or cached, against the one computed from scratch
+	bool matchesScratch(const ChessBoard& board)
+	{
+		return board.getAccumulator() == board.computeAccumulator() &&
+			board.getAttackTable(true).all == board.getThreatMap(true) &&
+			board.getAttackTable(false).all == board.getThreatMap(false);
+	}
+
+	// lazy evaluation with a random window around the full one
+	bool checkLazyEvaluation(const ChessBoard& board, PawnHashTable& pawnHash, std::mt19937& random)
+	{
+		int evaluation = Evaluation::EvaluatePosition(board, pawnHash);
+		int low = evaluation - static_cast<int>(random() % 400);
+		int high = evaluation + static_cast<int>(random() % 400);
+
+		bool lazy = false;
+		int lazyEvaluation = Evaluation::EvaluatePosition(board, pawnHash, low, high, lazy);
+
+		return lazy ? (lazyEvaluation <= low || lazyEvaluation >= high) : lazyEvaluation == evaluation;
+	}
+
+	// Plays the seeded random games from every position and reports every position. The visitor gets the board
+	// with every event (Start once per position) and returns false on an error
+	bool checkRandomGames(const std::vector<TestPosition>& positions, int games, int plies,
+		const std::function<bool(ChessBoard&, RandomGameEvent, std::mt19937&)>& visit)
+	{
+		// fixed seed, so a failure can be reproduced
+		std::mt19937 random(randomGamesSeed);
+		int success = 0;
+
+		for (const auto& position : positions)
+		{
+			ChessBoard board;
+			board.loadPosFromFen(position.fen);
+
+			int checks = 0;
+			bool passed = playRandomGames(board, games, plies, random, [&](RandomGameEvent event)
+				{
+					checks++;
+					return visit(board, event, random);
+				});
+
+			if (passed)
+			{
+				std::cout << "\033[32mPassed:\033[0m " << position.fen << " - " << checks << " positions" << std::endl;
+				success++;
+			}
+			else
+			{
+				std::cout << "\033[31mError:\033[0m " << position.fen << " - after " << checks << " positions" << std::endl;
+			}
+		}
+
+		std::cout << std::endl << success << " out of " << positions.size() << " positions were consistent" << std::endl;
+
+		return success == static_cast<int>(positions.size());
+	}
+
+	bool testIncrementalEvaluation(const std::vector<TestPosition>& positions, int games, int plies)
+	{
+		std::cout << "Starting Incremental Evaluation Test.." << std::endl << std::endl;
+
+		PawnHashTable pawnHash;
+
+		return checkRandomGames(positions, games, plies, [&](ChessBoard& board, RandomGameEvent event, std::mt19937& random)
+			{
+				if (event == RandomGameEvent::Node)
+				{
+					// every legal move is made and unmade once, then a random one is played
+					std::array<Move, Consts::MaxPossibleMoves> legalMoves = board.getLegalMoves();
+					size_t movesSize = board.getMovesSize();
+					bool passed = true;
+
+					for (size_t i = 0; i < movesSize && passed; i++)
+					{
+						board.makeMove(legalMoves[i]);
+						passed = matchesScratch(board);
+						board.unmakeMove();
+						passed = passed && matchesScratch(board);
+					}
+
+					return passed;
+				}
+
+				if (event == RandomGameEvent::Played)
+				{
+					return checkLazyEvaluation(board, pawnHash, random) &&
+						Evaluation::EvaluatePositionStatic(board, pawnHash) == Evaluation::EvaluatePositionStatic(board);
+				}
+
+				return matchesScratch(board);
+			});
+	}
+
+	bool testNnue(const std::vector<TestPosition>& positions, int games, int plies)
+	{
+		std::cout << "Starting NNUE Test.." << std::endl << std::endl;
+
+		// fixed seeds, so a failure can be reproduced
+		std::unique_ptr<Nnue::Network> network = Nnue::Network::random(randomGamesSeed);
+		std::mt19937 random(randomGamesSeed);
+
+		// kernels on random accumulators, including values outside of the clipping range
+		std::uniform_int_distribution<int> value(-1000, 1000);
+		alignas(64) std::array<int16_t, Nnue::hiddenSize> us;
+		alignas(64) std::array<int16_t, Nnue::hiddenSize> them;
+		bool kernelsPassed = true;
+
+		for (int i = 0; i < 1000 && kernelsPassed; i++)
+		{
+			std::generate(us.begin(), us.end(), [&]() { return static_cast<int16_t>(value(random)); });
+			std::generate(them.begin(), them.end(), [&]() { return static_cast<int16_t>(value(random)); });
+
+			kernelsPassed = Nnue::outputLayer(us.data(), them.data(), network->outputWeights.data())
+				== Nnue::outputLayerScalar(us.data(), them.data(), network->outputWeights.data());
+		}
+
+		std::cout << (kernelsPassed ? "\033[32mPassed:\033[0m" : "\033[31mError:\033[0m") << " output layer kernel" << std::endl;
+
+		std::string fileName = (std::filesystem::temp_directory_path() / "chess-tests.nnue").string();
+		std::unique_ptr<Nnue::Network> loaded = network->save(fileName) ? Nnue::Network::load(fileName) : nullptr;
+		std::filesystem::remove(fileName);
+
+		bool filePassed = loaded && loaded->featureWeights == network->featureWeights && loaded->featureBiases == network->featureBiases
+			&& loaded->outputWeights == network->outputWeights && loaded->outputBias == network->outputBias;
+
+		std::cout << (filePassed ? "\033[32mPassed:\033[0m" : "\033[31mError:\033[0m") << " save and load" << std::endl;
+
+		std::optional<Nnue::Evaluator> evaluator;
+
+		bool gamesPassed = checkRandomGames(positions, games, plies, [&](ChessBoard& board, RandomGameEvent event, std::mt19937& random)
+			{
+				// evaluations from scratch, every check uses a new evaluator
+				auto consistent = [&]() { return evaluator->evaluate(board) == Nnue::Evaluator(*network).evaluate(board); };
+
+				switch (event)
+				{
+				case RandomGameEvent::Start:
+				{
+					evaluator.emplace(*network);
+					return true;
+				}
+				case RandomGameEvent::Node:
+				{
+					// a few children are evaluated like in a search, then a random move is played
+					std::array<Move, Consts::MaxPossibleMoves> legalMoves = board.getLegalMoves();
+					size_t movesSize = board.getMovesSize();
+					bool passed = true;
+
+					for (size_t i = 0; i < movesSize && i < 4 && passed; i++)
+					{
+						board.makeMove(legalMoves[random() % movesSize]);
+						passed = consistent();
+						board.unmakeMove();
+					}
+
+					return passed;
+				}
+				case RandomGameEvent::Played:
+				{
+					// skipped plies leave gaps the evaluator has to bridge
+					return random() % 3 != 0 || consistent();
+				}
+				default:
+				{
+					return consistent();
+				}
+				}
+			});
+
+		return kernelsPassed && filePassed && gamesPassed;
+	}
+
+	bool testTuning(const std::vector<TestPosition>& positions, int games, int plies)
+	{
+		std::cout << "Starting Tuning Test.." << std::endl << std::endl;
+
+		const std::vector<std::pair<std::string, double>> labels = {
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1 [1.0]", 1.0 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 [0.5]", 0.5 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - c9 \"0-1\";", 0.0 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1 1/2-1/2", 0.5 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1 | 35 | 1.0", 1.0 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1", -1.0 },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1 [2.0]", -1.0 }
+		};
+
+		bool labelsPassed = true;
+
+		for (const auto& [line, result] : labels)
+		{
+			labelsPassed = labelsPassed && Tuning::Tuner::parseResult(line) == result;
+		}
+
+		std::cout << (labelsPassed ? "\033[32mPassed:\033[0m" : "\033[31mError:\033[0m") << " result labels" << std::endl;
+
+		if (!Evaluation::hasTunedWeights)
+		{
+			std::cout << "\033[31mError:\033[0m EvaluationWeights.h does not match the parameters, regenerate it with chess-tune" << std::endl;
+		}
+
+		bool gamesPassed = checkRandomGames(positions, games, plies, [](ChessBoard& board, RandomGameEvent event, std::mt19937&)
+			{
+				if (event != RandomGameEvent::Node)
+				{
+					return true;
+				}
+
+				Evaluation::Trace trace = Evaluation::traceEvaluation(board);
+				return trace.specialized || Evaluation::evaluateTrace(trace, Evaluation::evaluationWeights) == Evaluation::EvaluatePositionStatic(board);
+			});
+
+		return labelsPassed && Evaluation::hasTunedWeights && gamesPassed;
+	}
+
+	bool testPawnHash(const std::vector<std::string>& fens)
+	{
+		std::cout << "Starting Pawn Hash Test.." << std::endl << std::endl;
+
+		int success = 0;
+
+		for (const auto& fen : fens)
+		{
+			ChessBoard board;
+			board.loadPosFromFen(fen);
+
+			PawnHashTable pawnHash;
+
+			int evaluation = Evaluation::EvaluatePositionStatic(board);
+			int missEvaluation = Evaluation::EvaluatePositionStatic(board, pawnHash);
+			int hitEvaluation = Evaluation::EvaluatePositionStatic(board, pawnHash);
+
+			std::string result = std::to_string(evaluation) + " / " + std::to_string(missEvaluation) + " / " + std::to_string(hitEvaluation);
+
+			if (evaluation == missEvaluation && evaluation == hitEvaluation)
+			{
+				std::cout << "\033[32mPassed:\033[0m " << fen << " - " << result << std::endl;
+				success++;
+			}
+			else
+			{
+				std::cout << "\033[31mError:\033[0m " << fen << " - " << result << std::endl;
+			}
+		}
+
+		std::cout << std::endl << success << " out of " << fens.size() << " positions were consistent" << std::endl;
+
+		return success == static_cast<int>(fens.size());
+	}
+
+	bool testEndgameEvaluation(const std::vector<EndgameTestPosition>& positions)
+	{
+		std::cout << "Starting Endgame Evaluation Test.." << std::endl << std::endl;
+
+		int success = 0;
+
+		for (const auto& position : positions)
+		{
+			ChessBoard board;
+			board.loadPosFromFen(position.fen);
+
+			int evaluation = Evaluation::EvaluatePositionStatic(board);
+			bool passed =
+				position.expected > 0 ? evaluation >= Endgames::knownWin :
+				position.expected < 0 ? evaluation <= -Endgames::knownWin :
+				std::abs(evaluation) < Evaluation::pieceValues[Piece::Pawn];
+
+			if (passed)
+			{
+				std::cout << "\033[32mPassed:\033[0m " << position.fen << " - " << evaluation << std::endl;
+				success++;
+			}
+			else
+			{
+				std::cout << "\033[31mError:\033[0m " << position.fen << " - " << evaluation << std::endl;
+			}
+		}
+
+		std::cout << std::endl << success << " out of " << positions.size() << " positions were evaluated correctly" << std::endl;
+
+		return success == static_cast<int>(positions.size());
 	}
-}
\ No newline at end of file
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace Chess::Test
 {
 	struct TestPosition
@@ -9,8 +13,64 @@ namespace Chess::Test
 		std::string fen;
 	};
 
+	struct SearchTestPosition
+	{
+		int depth;
+		uint64_t nodes;		// 0 = only depth limited
+		std::string fen;
+	};
+
+	// Mate in the given number of moves for the side to move, the best move in coordinate notation
+	struct MateTestPosition
+	{
+		int moves;
+		std::string bestMove;
+		std::string fen;
+	};
+
+	// Endgame position and the evaluation the endgame registry has to give it
+	struct EndgameTestPosition
+	{
+		int expected;		// 1 won for white, -1 won for black, 0 drawn or drawish
+		std::string fen;
+	};
+
 	extern const std::vector<TestPosition> testGithub;
 	extern const std::vector<TestPosition> testDefault;
+	extern const std::vector<SearchTestPosition> testSearch;
+	extern const std::vector<MateTestPosition> testMates;
+	extern const std::vector<EndgameTestPosition> testEndgames;
+	extern const std::vector<std::string> testPawnStructures;
+
+	// True if every position passed
+	bool testMoveGeneration(const std::vector<TestPosition>& positions);
+
+	// Plays random games from every position, the incrementally updated evaluation accumulator and the
+	// cached attack tables have to match the ones computed from scratch after every make and unmake, the lazy evaluation
+	// has to return the full one inside its window or a score outside of it, and the pawn hash table must not change
+	// the evaluation
+	bool testIncrementalEvaluation(const std::vector<TestPosition>& positions, int games, int plies);
+
+	// Plays random games with a random network, the lazily updated accumulators have to give the same
+	// evaluation as a fresh evaluator, the SIMD output layer the same sum as the scalar one, and the
+	// network has to survive a save and load
+	bool testNnue(const std::vector<TestPosition>& positions, int games, int plies);
+
+	// Plays random games, the evaluation rebuilt from the tuner's trace has to match the static evaluation
+	// in every position without a specialized endgame, the data set labels have to parse and EvaluationWeights.h
+	// has to match the parameters
+	bool testTuning(const std::vector<TestPosition>& positions, int games, int plies);
+
+	// Every position is evaluated without a pawn hash table and twice with a fresh one (miss and hit),
+	// all three evaluations have to match
+	bool testPawnHash(const std::vector<std::string>& fens);
+
+	// Won positions have to be evaluated as known wins, drawn ones below a pawn
+	bool testEndgameEvaluation(const std::vector<EndgameTestPosition>& positions);
+
+	// Searches every position twice with fresh tables, best move and node count have to match
+	bool testSearchDeterminism(const std::vector<SearchTestPosition>& positions);
 
-	void testMoveGeneration(const std::vector<TestPosition>& positions);
+	// A mate in n has to be found at depth 2n - 1 with the expected move and the score of a mate at ply 2n - 1
+	bool testMateSearch(const std::vector<MateTestPosition>& positions);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <iostream>
+#include <string>
+
+#include "Tests.h"
+#include "Zobrist.h"
+
+// usage: chess-tests <perft | perft-full | search | mate | eval | nnue | tuning | pawnhash | endgames>, returns 0 if every position passed
+int main(int argc, char* argv[])
+{
+	Chess::Zobrist();
+
+	std::string test = argc > 1 ? argv[1] : "";
+	bool passed = false;
+
+	if (test == "perft") passed = Chess::Test::testMoveGeneration(Chess::Test::testGithub);
+	else if (test == "perft-full") passed = Chess::Test::testMoveGeneration(Chess::Test::testDefault);
+	else if (test == "search") passed = Chess::Test::testSearchDeterminism(Chess::Test::testSearch);
+	else if (test == "mate") passed = Chess::Test::testMateSearch(Chess::Test::testMates);
+	else if (test == "eval") passed = Chess::Test::testIncrementalEvaluation(Chess::Test::testGithub, 20, 60);
+	else if (test == "nnue") passed = Chess::Test::testNnue(Chess::Test::testGithub, 10, 60);
+	else if (test == "tuning") passed = Chess::Test::testTuning(Chess::Test::testGithub, 20, 60);
+	else if (test == "pawnhash") passed = Chess::Test::testPawnHash(Chess::Test::testPawnStructures);
+	else if (test == "endgames") passed = Chess::Test::testEndgameEvaluation(Chess::Test::testEndgames);
+	else
+	{
+		std::cerr << "usage: chess-tests <perft | perft-full | search | mate | eval | nnue | tuning | pawnhash | endgames>" << std::endl;
+		return 1;
+	}
+
+	return passed ? 0 : 1;
+}
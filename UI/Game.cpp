@@ -141,6 +141,7 @@ void Game::updateData()
 	debugData = gameManager.getDebugData();
 
 	loadBookMoves();
+	loadSearchLines();
 }
 
 
@@ -204,6 +205,28 @@ void Game::loadBookMoves()
 	}
 }
 
+void Game::loadSearchLines()
+{
+	searchLines.clear();
+
+	const auto& lines = gameManager.getSearchLines();
+
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		if (lines[i].moves.empty())
+		{
+			continue;
+		}
+
+		// the best line is the darkest one
+		float lineRank = lines.size() > 1 ? (float)i / (lines.size() - 1) : 0.0f;
+		Color arrowColor = Utils::mixColors(DARKBLUE, SKYBLUE, lineRank);
+
+		Chess::Move move = lines[i].moves.front();
+		searchLines.push_back(Arrow{ move.from, move.to, arrowColor });
+	}
+}
+
 
 Sound Game::getMoveSound(Chess::Move move)
 {
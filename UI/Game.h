@@ -60,6 +60,7 @@ private:
 	// Textures & Drawing
 	std::map<Chess::Piece, Texture2D> pieceTextures;
 	std::vector<Arrow> bookMoves;
+	std::vector<Arrow> searchLines;
 
 	AssetManager assets = AssetManager();
 
@@ -71,10 +72,12 @@ private:
 	bool displayPinMaskWhite = false;
 	bool displayPinMaskBlack = false;
 	bool displayBookMoves = false;
+	bool displaySearchLines = false;
 	bool flipped = false;
 
 	std::function<void(Chess::GameMode)> gameModeSetter = [&](Chess::GameMode mode) { gameManager.setGameMode(mode); };
 	std::function<void(Chess::TimeControl)> timeControlSetter = [&](Chess::TimeControl control) { gameManager.setTimeControl(control); };
+	std::function<void(int)> multiPVSetter = [&](int lines) { gameManager.setMultiPV(lines); };
 
 	Button* gameModeButton = new ToggleTextButton<Chess::GameMode>
 	(
@@ -84,6 +87,7 @@ private:
 		{
 			{Chess::GameMode::Human, "Human"},
 			{Chess::GameMode::Computer, "Computer"},
+			{Chess::GameMode::Analysis, "Analysis"},
 		},
 		gameModeSetter
 	);
@@ -101,6 +105,19 @@ private:
 			timeControlSetter
 		);
 
+	Button* multiPVButton = new ToggleTextButton<int>
+		(
+			Rectangle{ buttonsX, offsetY + btnDist * 5, btnWidth, btnHeight },
+			GOLD,
+			btnFont,
+			{
+				{1, "1 Line"},
+				{3, "3 Lines"},
+				{5, "5 Lines"},
+			},
+			multiPVSetter
+		);
+
 	std::vector<Button*> buttons = {
 		new FunctionalButton { Rectangle {buttonsX, offsetY, btnWidth, btnHeight}, PURPLE, btnFont, "Undo Move", [this]() { unmakeMove(); }},
 		new FunctionalButton { Rectangle {buttonsX, offsetY + btnDist, btnWidth, btnHeight}, PURPLE, btnFont, "New Game", [this]() { gameManager.startNewGame(); }},
@@ -115,6 +132,8 @@ private:
 			gameManager.startNewGame();
 		}},
 
+		multiPVButton,
+
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 6, btnWidth, btnHeight}, BLUE, btnFont, "White ThreatMap", displayThreatMapWhite },
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 7, btnWidth, btnHeight}, BLUE, btnFont, "Black ThreatMap", displayThreatMapBlack },
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 8.5f, btnWidth, btnHeight}, BLUE, btnFont, "White CheckMask", displayCheckMaskWhite },
@@ -122,6 +141,7 @@ private:
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 11, btnWidth, btnHeight}, BLUE, btnFont, "White PinMask", displayPinMaskWhite },
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 12, btnWidth, btnHeight}, BLUE, btnFont, "Black PinMask", displayPinMaskBlack },
 		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 13.5f, btnWidth, btnHeight}, BLUE, btnFont, "Book Moves", displayBookMoves },
+		new ToggleButton { Rectangle {buttonsX, offsetY + btnDist * 14.5f, btnWidth, btnHeight}, BLUE, btnFont, "Search Lines", displaySearchLines },
 	};
 
 	Input fenInput = Input(Rectangle{ offsetX, SquareSize * 8 + offsetY + 10, SquareSize * 8, 30}, SKYBLUE, 20, "FEN");
@@ -133,6 +153,7 @@ private:
 	int calculateSelectedSquare(Vector2 mousePosition);
 	std::vector<Chess::Move> getMovesFromSquare(int square);
 	void loadBookMoves();
+	void loadSearchLines();
 
 	void makeMove(Chess::Move move);
 	void unmakeMove();
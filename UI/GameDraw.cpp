@@ -1,3 +1,6 @@
+#include <format>
+#include <string>
+
 #include "Game.h"
 
 
@@ -51,6 +54,14 @@ void Game::draw()
 		}
 	}
 
+	if (displaySearchLines)
+	{
+		for (const Arrow& lineArrow : searchLines)
+		{
+			lineArrow.draw();
+		}
+	}
+
 	// Draw buttons
 	for (auto& button : buttons)
 	{
@@ -222,20 +233,20 @@ void Game::loadTextures()
 void Game::drawSearchData()
 {
 	const int posX = buttonsX;
-	const int posY = offsetY + SquareSize * 6;
+	const int posY = offsetY + btnDist * 15.5f;
 	const int width = 220;
 	const int height = 35;
-	const int statSize = 5;
+	const int statSize = 6;
 	const int fontSize = 20;
 
 	Chess::SearchStats searchStats = debugData.searchStats;
 
-	const Color colors[] = { SKYBLUE, GREEN, GOLD, ORANGE, PURPLE };
-	const int stats[] = { searchStats.depth, searchStats.nodesEvaluated, searchStats.nodesPruned,
-						searchStats.nodesTransposed, searchStats.nodesVisited };
+	const Color colors[] = { SKYBLUE, GREEN, GOLD, ORANGE, PURPLE, LIME };
+	const uint64_t stats[] = { static_cast<uint64_t>(searchStats.depth), searchStats.nodesEvaluated, searchStats.nodesPruned,
+						searchStats.nodesTransposed, searchStats.nodesVisited, searchStats.nodesPerSecond };
 
 
-	const char* captions[] = { "Depth: ", "Evaluated: ", "Pruned: ", "Transosed: ", "Visited: "};
+	const char* captions[] = { "Depth: ", "Evaluated: ", "Pruned: ", "Transosed: ", "Visited: ", "NPS: "};
 
 	for (int i = 0; i < statSize; i++)
 	{
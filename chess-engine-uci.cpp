@@ -0,0 +1,74 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "Uci.h"
+#include "Zobrist.h"
+
+// one fen per line replaces the default positions
+bool readFens(const std::string& fileName, std::vector<std::string>& fens)
+{
+	std::ifstream file(fileName);
+	if (!file)
+	{
+		std::cerr << "Could not open " << fileName << std::endl;
+		return false;
+	}
+
+	fens.clear();
+	for (std::string line; std::getline(file, line);)
+	{
+		if (!line.empty()) fens.push_back(line);
+	}
+
+	return true;
+}
+
+// usage: chess-engine-uci [bench [depth] [fen file] | evalbench [plies] [fen file]], without arguments it speaks UCI on stdin/stdout
+int main(int argc, char* argv[])
+{
+	Chess::Zobrist();
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+
+	if (!args.empty() && args[0] == "bench")
+	{
+		int depth = args.size() > 1 ? std::stoi(args[1]) : Chess::Bench::defaultDepth;
+		std::vector<std::string> fens = Chess::Bench::defaultPositions;
+
+		if (args.size() > 2 && !readFens(args[2], fens))
+		{
+			return 1;
+		}
+
+		Chess::Bench::run(fens, depth, std::cout);
+		return 0;
+	}
+
+	// evaluation speed of the SIMD and the scalar kernels, fails if they disagree
+	if (!args.empty() && args[0] == "evalbench")
+	{
+		int plies = args.size() > 1 ? std::stoi(args[1]) : Chess::Bench::defaultEvalPlies;
+		std::vector<std::string> fens = Chess::Bench::defaultPositions;
+
+		if (args.size() > 2 && !readFens(args[2], fens))
+		{
+			return 1;
+		}
+
+		return Chess::Bench::runEval(fens, plies, std::cout).consistent ? 0 : 1;
+	}
+
+	if (!args.empty())
+	{
+		std::cerr << "usage: chess-engine-uci [bench [depth] [fen file] | evalbench [plies] [fen file]]" << std::endl;
+		return 1;
+	}
+
+	Chess::Uci uci(std::cin, std::cout);
+	uci.loop();
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Tuner.h"
+#include "Zobrist.h"
+
+// usage: chess-tune <data file> [epochs] [learning rate] [header], writes the tuned weights as EvaluationWeights.h
+// (copy it over Chess/AI/EvaluationWeights.h and rebuild)
+int main(int argc, char* argv[])
+{
+	Chess::Zobrist();
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+
+	if (args.empty())
+	{
+		std::cerr << "usage: chess-tune <data file> [epochs] [learning rate] [header]" << std::endl;
+		return 1;
+	}
+
+	int epochs = args.size() > 1 ? std::stoi(args[1]) : 1000;
+	double learningRate = args.size() > 2 ? std::stod(args[2]) : 1.0;
+	std::string header = args.size() > 3 ? args[3] : "EvaluationWeights.h";
+
+	if (!Chess::Evaluation::hasTunedWeights)
+	{
+		std::cout << "EvaluationWeights.h does not match the parameters, starting from the initial weights" << std::endl;
+	}
+
+	Chess::Tuning::Tuner tuner(static_cast<int>(std::thread::hardware_concurrency()));
+
+	if (tuner.load(args[0], std::cout) == 0)
+	{
+		std::cerr << "No labeled positions in " << args[0] << std::endl;
+		return 1;
+	}
+
+	std::cout << "K " << tuner.fitK() << " loss " << tuner.loss() << std::endl;
+
+	tuner.optimize(epochs, learningRate, header, std::cout);
+
+	if (!tuner.writeHeader(header))
+	{
+		std::cerr << "Could not write " << header << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << header << std::endl;
+	return 0;
+}